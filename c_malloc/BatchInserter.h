@@ -0,0 +1,145 @@
+#ifndef BATCH_INSERTER_H
+#define BATCH_INSERTER_H
+
+#include "ConnectionPool.h"
+#include "TableSchema.h"
+#include "TextArena.h"
+#include <sqlite3.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Inserts rows in transactions of batchSize through the pool's cached insert statement.
+// Rows are buffered with their text copied into an arena, so callers can hand over
+// rows that view short-lived parse buffers. The writer is only leased while a batch is
+// being written, never while the caller is still producing rows.
+//
+// Every item gets a result slot by its index: the assigned id, or an error from the
+// producer (reject) or from SQLite. Committed batches stay committed.
+template <typename Row>
+class BatchInserter {
+public:
+    struct ItemResult {
+        int64_t id = 0;
+        std::string error;
+    };
+
+    BatchInserter(ConnectionPool& pool, size_t batchSize)
+        : pool(pool), batchSize(batchSize > 0 ? batchSize : 1), inserted(0) {}
+
+    void add(size_t index, const Row& row) {
+        Row copy = row;
+        std::apply([&](const auto&... columns) {
+            (storeText(copy.*(columns.member)), ...);
+        }, TableSchema<Row>::columns);
+        pending.push_back(PendingRow{ index, copy });
+
+        if (pending.size() >= batchSize) {
+            flush();
+        }
+    }
+
+    void reject(size_t index, std::string error) {
+        slot(index).error = std::move(error);
+    }
+
+    // Writes everything still buffered; false if the batch could not be committed.
+    bool flush() {
+        if (pending.empty()) {
+            return true;
+        }
+
+        bool committed = writeBatch();
+        pending.clear();
+        arena.clear();
+        return committed;
+    }
+
+    const std::vector<ItemResult>& results() const { return items; }
+    size_t insertedCount() const { return inserted; }
+
+private:
+    struct PendingRow {
+        size_t index;
+        Row row;
+    };
+
+    template <typename T>
+    void storeText(T&) {}
+
+    void storeText(std::string_view& text) {
+        text = arena.store(text);
+    }
+
+    ItemResult& slot(size_t index) {
+        if (items.size() <= index) {
+            items.resize(index + 1);
+        }
+        return items[index];
+    }
+
+    bool execute(sqlite3* db, const char* sql) {
+        return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+
+    void failAll(const char* message) {
+        for (const PendingRow& pendingRow : pending) {
+            ItemResult& result = slot(pendingRow.index);
+            result.id = 0;
+            result.error = message;
+        }
+    }
+
+    bool writeBatch() {
+        auto conn = pool.acquireWriter();
+        sqlite3* db = conn.get();
+
+        if (!execute(db, "BEGIN TRANSACTION;")) {
+            failAll(sqlite3_errmsg(db));
+            return false;
+        }
+
+        size_t batchInserted = 0;
+        {
+            auto stmt = conn.prepare(Table<Row>::insertSql());
+            if (!stmt) {
+                failAll(sqlite3_errmsg(db));
+                execute(db, "ROLLBACK;");
+                return false;
+            }
+
+            // A failed row only aborts its own statement; the rest of the batch goes on
+            for (const PendingRow& pendingRow : pending) {
+                ItemResult& result = slot(pendingRow.index);
+                Table<Row>::bind(stmt.get(), pendingRow.row);
+                if (sqlite3_step(stmt.get()) == SQLITE_DONE) {
+                    result.id = sqlite3_last_insert_rowid(db);
+                    ++batchInserted;
+                }
+                else {
+                    result.error = sqlite3_errmsg(db);
+                }
+                sqlite3_reset(stmt.get());
+            }
+        }
+
+        if (!execute(db, "COMMIT;")) {
+            failAll(sqlite3_errmsg(db));
+            execute(db, "ROLLBACK;");
+            return false;
+        }
+        inserted += batchInserted;
+        return true;
+    }
+
+    ConnectionPool& pool;
+    size_t batchSize;
+    std::vector<PendingRow> pending;
+    TextArena arena;
+    std::vector<ItemResult> items;
+    size_t inserted;
+};
+
+#endif // BATCH_INSERTER_H
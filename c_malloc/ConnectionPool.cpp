@@ -0,0 +1,149 @@
+#include "ConnectionPool.h"
+#include <iostream>
+#include <utility>
+
+namespace {
+    // How long a connection waits on a locked database before reporting SQLITE_BUSY.
+    const int busyTimeoutMs = 5000;
+}
+
+ConnectionPool::Lease::Lease(ConnectionPool* pool, sqlite3* connection, StatementCache* statements,
+    std::unique_lock<std::recursive_mutex> writerLock)
+    : pool(pool), connection(connection), statements(statements), writerLock(std::move(writerLock)) {}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool), connection(other.connection), statements(other.statements),
+    writerLock(std::move(other.writerLock)) {
+    other.pool = nullptr;
+    other.connection = nullptr;
+    other.statements = nullptr;
+}
+
+ConnectionPool::Lease::~Lease() {
+    if (pool && connection) {
+        pool->release(connection);
+    }
+}
+
+ConnectionPool::ConnectionPool() : writer(nullptr) {}
+
+ConnectionPool::~ConnectionPool() {
+    close();
+}
+
+// Fails on an already open pool; close() it first so its connections are not leaked.
+bool ConnectionPool::open(const std::string& dbName, size_t readerCount) {
+    if (isOpen()) {
+        std::cerr << "Connection pool is already open" << std::endl;
+        return false;
+    }
+
+    writer = openConnection(dbName, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX);
+    if (!writer) {
+        return false;
+    }
+
+    if (readerCount == 0) {
+        return true;
+    }
+
+    // Readers only see a consistent snapshot alongside a live writer in WAL mode.
+    // In-memory databases cannot use WAL and silently keep their journal mode.
+    char* errMsg = nullptr;
+    if (sqlite3_exec(writer, "PRAGMA journal_mode=WAL;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Failed to enable WAL mode: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        close();
+        return false;
+    }
+
+    for (size_t i = 0; i < readerCount; ++i) {
+        sqlite3* reader = openConnection(dbName, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX);
+        if (!reader) {
+            close();
+            return false;
+        }
+        readers.push_back(reader);
+        idleReaders.push_back(reader);
+    }
+    return true;
+}
+
+// All leases must have been returned before closing.
+void ConnectionPool::close() {
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        for (sqlite3* reader : readers) {
+            closeConnection(reader);
+        }
+        readers.clear();
+        idleReaders.clear();
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(writerMutex);
+    if (writer) {
+        closeConnection(writer);
+        writer = nullptr;
+    }
+}
+
+bool ConnectionPool::isOpen() const {
+    return writer != nullptr;
+}
+
+ConnectionPool::Lease ConnectionPool::acquireWriter() {
+    std::unique_lock<std::recursive_mutex> lock(writerMutex);
+    return Lease(nullptr, writer, cacheFor(writer), std::move(lock));
+}
+
+ConnectionPool::Lease ConnectionPool::acquireReader() {
+    std::unique_lock<std::mutex> lock(readerMutex);
+    if (readers.empty()) {
+        lock.unlock();
+        return acquireWriter();
+    }
+
+    readerAvailable.wait(lock, [this] { return !idleReaders.empty(); });
+    sqlite3* reader = idleReaders.back();
+    idleReaders.pop_back();
+    return Lease(this, reader, cacheFor(reader), std::unique_lock<std::recursive_mutex>());
+}
+
+void ConnectionPool::forEachConnection(const std::function<void(sqlite3*)>& fn) {
+    if (writer) {
+        fn(writer);
+    }
+    for (sqlite3* reader : readers) {
+        fn(reader);
+    }
+}
+
+sqlite3* ConnectionPool::openConnection(const std::string& dbName, int flags) {
+    sqlite3* connection = nullptr;
+    if (sqlite3_open_v2(dbName.c_str(), &connection, flags | SQLITE_OPEN_URI, nullptr) != SQLITE_OK) {
+        std::cerr << "Can't open database: " << sqlite3_errmsg(connection) << std::endl;
+        sqlite3_close(connection);
+        return nullptr;
+    }
+    sqlite3_busy_timeout(connection, busyTimeoutMs);
+    statementCaches[connection] = std::make_unique<StatementCache>(connection);
+    return connection;
+}
+
+StatementCache* ConnectionPool::cacheFor(sqlite3* connection) const {
+    auto it = statementCaches.find(connection);
+    return it == statementCaches.end() ? nullptr : it->second.get();
+}
+
+void ConnectionPool::closeConnection(sqlite3* connection) {
+    statementCaches.erase(connection);
+    sqlite3_close(connection);
+}
+
+void ConnectionPool::release(sqlite3* connection) {
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        idleReaders.push_back(connection);
+    }
+    readerAvailable.notify_one();
+}
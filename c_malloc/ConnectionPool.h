@@ -0,0 +1,79 @@
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include "StatementCache.h"
+#include <sqlite3.h>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One writer connection plus N read-only connections to the same database.
+// Connections are opened with SQLITE_OPEN_NOMUTEX and only ever handed out through
+// leases, so each connection is used by a single thread at a time. With readers the
+// database is switched to WAL mode, letting reads run concurrently with the writer.
+class ConnectionPool {
+public:
+    // RAII handle to a pooled connection; returns it to the pool on destruction.
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        sqlite3* get() const { return connection; }
+        // Cached prepared statement of this connection; reset again when released.
+        ScopedStatement prepare(const std::string& sql) {
+            return statements ? statements->prepare(sql) : ScopedStatement(nullptr);
+        }
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool* pool, sqlite3* connection, StatementCache* statements,
+            std::unique_lock<std::recursive_mutex> writerLock);
+
+        ConnectionPool* pool;   // Set for reader leases only
+        sqlite3* connection;
+        StatementCache* statements;
+        std::unique_lock<std::recursive_mutex> writerLock;
+    };
+
+    ConnectionPool();
+    ~ConnectionPool();
+
+    bool open(const std::string& dbName, size_t readerCount);
+    void close();
+    bool isOpen() const;
+
+    // The writer is re-entrant on the owning thread, so nested write helpers share one lease.
+    Lease acquireWriter();
+    // Blocks until a reader is idle; falls back to the writer when the pool has no readers.
+    Lease acquireReader();
+
+    // Per-connection setup (tracing, pragmas); call while no leases are outstanding.
+    void forEachConnection(const std::function<void(sqlite3*)>& fn);
+
+private:
+    sqlite3* openConnection(const std::string& dbName, int flags);
+    StatementCache* cacheFor(sqlite3* connection) const;
+    void closeConnection(sqlite3* connection);
+    void release(sqlite3* connection);
+
+    sqlite3* writer;
+    std::recursive_mutex writerMutex;
+
+    std::vector<sqlite3*> readers;
+    std::vector<sqlite3*> idleReaders;
+    std::mutex readerMutex;
+    std::condition_variable readerAvailable;
+
+    // Filled while opening and read-only afterwards, so leases look up without locking
+    std::unordered_map<sqlite3*, std::unique_ptr<StatementCache>> statementCaches;
+};
+
+#endif // CONNECTION_POOL_H
@@ -0,0 +1,302 @@
+#ifndef CSV_ROW_STREAM_H
+#define CSV_ROW_STREAM_H
+
+#include "TableSchema.h"
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace csv_reader {
+    inline bool convertField(std::string_view text, std::string_view& value) {
+        value = text;
+        return true;
+    }
+
+    template <typename Integer>
+    bool convertInteger(std::string_view text, Integer& value) {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    inline bool convertField(std::string_view text, int& value) {
+        return convertInteger(text, value);
+    }
+
+    inline bool convertField(std::string_view text, int64_t& value) {
+        return convertInteger(text, value);
+    }
+
+    inline bool convertField(std::string_view text, double& value) {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    inline bool convertField(std::string_view text, bool& value) {
+        if (text == "true" || text == "TRUE" || text == "True" || text == "1") {
+            value = true;
+            return true;
+        }
+        if (text == "false" || text == "FALSE" || text == "False" || text == "0") {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    const char* expectedType() {
+        if constexpr (std::is_same<T, bool>::value) {
+            return "true or false";
+        }
+        else if constexpr (std::is_same<T, double>::value) {
+            return "a number";
+        }
+        else {
+            return "an integer";
+        }
+    }
+}
+
+// Incremental RFC 4180 CSV reader producing schema rows, the CSV counterpart of
+// JsonRowStream. The first record is a header naming the columns; it must contain
+// every schema column, in any order, and extra columns are ignored. Quoted fields
+// may contain commas, doubled quotes and line breaks. Fields are views of the input
+// buffer, or of scratch when quotes had to be unescaped.
+template <typename Row>
+class CsvRowStream {
+    using Schema = TableSchema<Row>;
+
+public:
+    static const size_t maxRecordBytes = 1024 * 1024;
+
+    CsvRowStream() : consumed(0), line(1), index(0), haveHeader(false), failed(false) {}
+
+    // onRow(index, row): the row's text views are only valid during the call.
+    // onError(index, message). Returns false once the stream is malformed.
+    template <typename OnRow, typename OnError>
+    bool feed(std::string_view data, OnRow&& onRow, OnError&& onError) {
+        if (failed) {
+            return false;
+        }
+        buffer.erase(0, consumed);
+        consumed = 0;
+        buffer.append(data.data(), data.size());
+        return readRecords(false, onRow, onError);
+    }
+
+    // Reads the last record, which need not end with a line break.
+    template <typename OnRow, typename OnError>
+    bool finish(OnRow&& onRow, OnError&& onError) {
+        if (failed) {
+            return false;
+        }
+        if (!readRecords(true, onRow, onError)) {
+            return false;
+        }
+        return haveHeader || fail("the file has no header row");
+    }
+
+    const std::string& error() const { return message; }
+    size_t itemCount() const { return index; }
+
+private:
+    template <typename OnRow, typename OnError>
+    bool readRecords(bool atEnd, OnRow& onRow, OnError& onError) {
+        while (consumed < buffer.size()) {
+            size_t recordLine = line;
+            size_t end = 0;
+            int status = splitRecord(atEnd, end);
+            if (status < 0) {
+                return false;
+            }
+            if (status == 0) {
+                return buffer.size() - consumed <= maxRecordBytes
+                    || fail("record at line " + std::to_string(recordLine) + " is too large");
+            }
+            consumed = end;
+
+            // Blank lines carry no record
+            if (fields.size() == 1 && fields[0].empty()) {
+                continue;
+            }
+            if (!haveHeader) {
+                if (!readHeader(recordLine)) {
+                    return false;
+                }
+                continue;
+            }
+
+            Row row{};
+            std::string rowError;
+            if (buildRow(row, rowError)) {
+                onRow(index++, row);
+            }
+            else {
+                onError(index++, "line " + std::to_string(recordLine) + ": " + rowError);
+            }
+        }
+        return true;
+    }
+
+    // Splits the record starting at `consumed` into fields.
+    // Returns 1 with `end` past its line break, 0 if more input is needed, -1 on error.
+    int splitRecord(bool atEnd, size_t& end) {
+        fields.clear();
+        scratch.clear();
+        if (scratch.capacity() < buffer.size() - consumed) {
+            scratch.reserve(buffer.size() - consumed);
+        }
+
+        size_t pos = consumed;
+        size_t lines = 0;
+        while (true) {
+            if (pos < buffer.size() && buffer[pos] == '"') {
+                size_t scratchStart = scratch.size();
+                bool copied = false;
+                size_t start = ++pos;
+                while (true) {
+                    size_t quote = buffer.find('"', pos);
+                    if (quote == std::string::npos || quote + 1 == buffer.size()) {
+                        if (!atEnd) {
+                            return 0;
+                        }
+                        if (quote == std::string::npos) {
+                            fail("unterminated quoted field at line " + std::to_string(line));
+                            return -1;
+                        }
+                    }
+                    for (size_t i = pos; i < quote; ++i) {
+                        lines += buffer[i] == '\n';
+                    }
+                    if (quote + 1 < buffer.size() && buffer[quote + 1] == '"') {
+                        // Doubled quote: keep one and continue in scratch
+                        if (!copied) {
+                            scratch.append(buffer, start, quote - start);
+                            copied = true;
+                        }
+                        else {
+                            scratch.append(buffer, pos, quote - pos);
+                        }
+                        scratch += '"';
+                        pos = quote + 2;
+                        continue;
+                    }
+                    if (copied) {
+                        scratch.append(buffer, pos, quote - pos);
+                        fields.emplace_back(scratch.data() + scratchStart, scratch.size() - scratchStart);
+                    }
+                    else {
+                        fields.emplace_back(buffer.data() + start, quote - start);
+                    }
+                    pos = quote + 1;
+                    break;
+                }
+            }
+            else {
+                size_t stop = buffer.find_first_of(",\n", pos);
+                if (stop == std::string::npos) {
+                    if (!atEnd) {
+                        return 0;
+                    }
+                    stop = buffer.size();
+                }
+                size_t length = stop - pos;
+                if ((stop == buffer.size() || buffer[stop] == '\n') && length > 0 && buffer[stop - 1] == '\r') {
+                    --length;
+                }
+                fields.emplace_back(buffer.data() + pos, length);
+                pos = stop;
+            }
+
+            if (pos < buffer.size() && buffer[pos] == '\r') {
+                ++pos;
+            }
+            if (pos == buffer.size()) {
+                if (!atEnd) {
+                    return 0;
+                }
+                end = pos;
+                line += lines + 1;
+                return 1;
+            }
+            if (buffer[pos] == '\n') {
+                end = pos + 1;
+                line += lines + 1;
+                return 1;
+            }
+            if (buffer[pos] != ',') {
+                fail("unexpected character after quoted field at line " + std::to_string(line + lines));
+                return -1;
+            }
+            ++pos;
+        }
+    }
+
+    bool readHeader(size_t recordLine) {
+        positions.clear();
+        const char* missing = nullptr;
+        std::apply([&](const auto&... columns) {
+            ((positions.push_back(findField(columns.name)),
+                missing = (!missing && positions.back() == fields.size()) ? columns.name : missing), ...);
+        }, Schema::columns);
+        if (missing) {
+            return fail("header at line " + std::to_string(recordLine) + " has no column '" + missing + "'");
+        }
+        headerSize = fields.size();
+        haveHeader = true;
+        return true;
+    }
+
+    size_t findField(const char* name) const {
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i] == name) {
+                return i;
+            }
+        }
+        return fields.size();
+    }
+
+    bool buildRow(Row& row, std::string& rowError) {
+        if (fields.size() != headerSize) {
+            rowError = "expected " + std::to_string(headerSize) + " fields, found " + std::to_string(fields.size());
+            return false;
+        }
+
+        size_t column = 0;
+        std::apply([&](const auto&... columns) {
+            ((rowError.empty() ? convertColumn(columns.name, fields[positions[column]], row.*(columns.member), rowError) : void(), ++column), ...);
+        }, Schema::columns);
+        return rowError.empty();
+    }
+
+    template <typename T>
+    static void convertColumn(const char* name, std::string_view text, T& value, std::string& rowError) {
+        if (!csv_reader::convertField(text, value)) {
+            rowError = std::string("field '") + name + "' must be " + csv_reader::expectedType<T>();
+        }
+    }
+
+    bool fail(std::string text) {
+        message = std::move(text);
+        failed = true;
+        return false;
+    }
+
+    std::string buffer;
+    size_t consumed;        // Bytes of buffer already handed out
+    size_t line;            // Line number of the record at `consumed`
+    std::string scratch;
+    std::vector<std::string_view> fields;
+    std::vector<size_t> positions;      // Header position of each schema column
+    size_t headerSize = 0;
+    std::string message;
+    size_t index;
+    bool haveHeader;
+    bool failed;
+};
+
+#endif // CSV_ROW_STREAM_H
@@ -1,240 +1,1144 @@
 #include "DatabaseManager.h"
 #include <iostream>
+#include <filesystem>
 #include <fstream>
 #include <stdexcept>
 #include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+namespace {
+    // View a text column without copying; empty for NULL.
+    std::string_view columnText(sqlite3_stmt* stmt, int column) {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+        if (!text) {
+            return std::string_view();
+        }
+        return std::string_view(text, static_cast<size_t>(sqlite3_column_bytes(stmt, column)));
+    }
+
+    // Full-text search needs an SQLite built with SQLITE_ENABLE_FTS5; without it the
+    // search tables are skipped and the search calls fail.
+    bool searchSupported() {
+        return sqlite3_compileoption_used("ENABLE_FTS5") != 0;
+    }
+
+    // Turn free text into an FTS5 query where every word is a quoted prefix term,
+    // so user input can never be parsed as FTS5 operators: ali smi -> "ali"* "smi"*
+    std::string toPrefixMatch(const std::string& query) {
+        std::istringstream words(query);
+        std::string word;
+        std::string match;
+        while (words >> word) {
+            if (!match.empty()) {
+                match += ' ';
+            }
+            match += '"';
+            for (char c : word) {
+                if (c == '"') {
+                    match += '"';
+                }
+                match += c;
+            }
+            match += "\"*";
+        }
+        return match;
+    }
+
+    std::string_view trim(std::string_view text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos) {
+            return std::string_view();
+        }
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    // Split "first,last,phone,department" into trimmed fields; false if the field count is wrong
+    bool parseStudentLine(std::string_view line, std::string_view (&fields)[4]) {
+        size_t field = 0;
+        while (field < 4) {
+            size_t comma = line.find(',');
+            if (field == 3) {
+                if (comma != std::string_view::npos) {
+                    return false;
+                }
+                fields[field++] = trim(line);
+                break;
+            }
+            if (comma == std::string_view::npos) {
+                return false;
+            }
+            fields[field++] = trim(line.substr(0, comma));
+            line.remove_prefix(comma + 1);
+        }
+        return true;
+    }
+
+    // Step through all rows of a prepared statement, stopping early if the visitor returns false.
+    template <typename Row, typename Extract>
+    bool visitRows(sqlite3* db, sqlite3_stmt* stmt, const std::function<bool(const Row&)>& visitor, Extract extract) {
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            if (!visitor(extract(stmt))) {
+                return true;
+            }
+        }
+        if (rc != SQLITE_DONE) {
+            std::cerr << "Failed to step statement: " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Shared stepping for keyset pages: advances the cursor to the last visited id
+    // and marks it done once a page comes back short.
+    template <typename Row, typename Extract>
+    bool visitPage(sqlite3* db, sqlite3_stmt* stmt, PageCursor& cursor, int limit,
+        const std::function<bool(const Row&)>& visitor, Extract extract) {
+        int count = 0;
+        bool stopped = false;
+        bool ok = visitRows<Row>(db, stmt, [&](const Row& row) {
+            ++count;
+            cursor.afterId = row.id;
+            stopped = !visitor(row);
+            return !stopped;
+        }, extract);
+
+        if (ok && !stopped && count < limit) {
+            cursor.done = true;
+        }
+        return ok;
+    }
+
+    // Accumulates output in a large buffer and hands it to the stream in big writes.
+    // Output goes to "<path>.part" and only replaces `path` on commit(), so a failed
+    // export leaves any previous file in place.
+    class BufferedFileWriter {
+    public:
+        explicit BufferedFileWriter(const std::string& path)
+            : path(path), partPath(path + ".part"), out(partPath, std::ios::binary | std::ios::trunc),
+            committed(false) {
+            buffer.reserve(bufferSize);
+        }
+
+        ~BufferedFileWriter() {
+            if (!committed) {
+                out.close();
+                std::error_code ec;
+                std::filesystem::remove(partPath, ec);
+            }
+        }
+
+        bool isOpen() const { return static_cast<bool>(out); }
+
+        void write(const char* data, size_t size) {
+            if (buffer.size() + size > bufferSize) {
+                flush();
+            }
+            if (size >= bufferSize) {
+                out.write(data, static_cast<std::streamsize>(size));
+                return;
+            }
+            buffer.insert(buffer.end(), data, data + size);
+        }
+
+        void write(std::string_view text) { write(text.data(), text.size()); }
+
+        void put(char c) {
+            if (buffer.size() == bufferSize) {
+                flush();
+            }
+            buffer.push_back(c);
+        }
+
+        // Fixed-width little-endian integers for the binary format
+        void writeUint32(uint32_t value) {
+            char bytes[4];
+            for (int i = 0; i < 4; ++i) {
+                bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+            }
+            write(bytes, sizeof(bytes));
+        }
+
+        void writeUint64(uint64_t value) {
+            char bytes[8];
+            for (int i = 0; i < 8; ++i) {
+                bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+            }
+            write(bytes, sizeof(bytes));
+        }
+
+        bool flush() {
+            if (!buffer.empty()) {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+            return static_cast<bool>(out);
+        }
+
+        bool commit() {
+            if (!flush()) {
+                return false;
+            }
+            out.close();
+            if (!out) {
+                return false;
+            }
+            std::error_code ec;
+            std::filesystem::rename(partPath, path, ec);
+            if (ec) {
+                return false;
+            }
+            committed = true;
+            return true;
+        }
+
+    private:
+        static const size_t bufferSize = 1 << 20;
+
+        std::string path;
+        std::string partPath;
+        std::ofstream out;
+        std::vector<char> buffer;
+        bool committed;
+    };
+
+    // RFC 4180 field: quoted only when it contains a separator, quote or line break
+    void writeCsvField(BufferedFileWriter& writer, std::string_view field) {
+        if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+            writer.write(field);
+            return;
+        }
+        writer.put('"');
+        for (char c : field) {
+            if (c == '"') {
+                writer.put('"');
+            }
+            writer.put(c);
+        }
+        writer.put('"');
+    }
+
+    void writeCsvRow(BufferedFileWriter& writer, sqlite3_stmt* stmt, int columnCount) {
+        for (int i = 0; i < columnCount; ++i) {
+            if (i > 0) {
+                writer.put(',');
+            }
+            if (sqlite3_column_type(stmt, i) != SQLITE_NULL) {
+                writeCsvField(writer, columnText(stmt, i));
+            }
+        }
+        writer.write("\r\n");
+    }
+
+    // Binary row: one SQLite type tag byte per value, followed by an 8-byte integer or
+    // double, a uint32 length-prefixed text/blob, or nothing for NULL.
+    void writeBinaryRow(BufferedFileWriter& writer, sqlite3_stmt* stmt, int columnCount) {
+        writer.put(1);
+        for (int i = 0; i < columnCount; ++i) {
+            int type = sqlite3_column_type(stmt, i);
+            writer.put(static_cast<char>(type));
+            switch (type) {
+            case SQLITE_INTEGER:
+                writer.writeUint64(static_cast<uint64_t>(sqlite3_column_int64(stmt, i)));
+                break;
+            case SQLITE_FLOAT: {
+                double value = sqlite3_column_double(stmt, i);
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                writer.writeUint64(bits);
+                break;
+            }
+            case SQLITE_TEXT: {
+                std::string_view text = columnText(stmt, i);
+                writer.writeUint32(static_cast<uint32_t>(text.size()));
+                writer.write(text);
+                break;
+            }
+            case SQLITE_BLOB: {
+                int size = sqlite3_column_bytes(stmt, i);
+                writer.writeUint32(static_cast<uint32_t>(size));
+                writer.write(static_cast<const char*>(sqlite3_column_blob(stmt, i)), static_cast<size_t>(size));
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+}
 
 // Constructor and Destructor
-DatabaseManager::DatabaseManager(const std::string& dbName) : dbName(dbName), db(nullptr) {}
+DatabaseManager::DatabaseManager(const std::string& dbName)
+    : dbName(dbName), snapshot(std::make_shared<StudentSnapshot>()), snapshotEpoch(0), inMemory(false),
+    stopFlusher(false) {}
 
 DatabaseManager::~DatabaseManager() {
     closeDatabase();
 }
 
-bool DatabaseManager::openDatabase() {
-    if (sqlite3_open(dbName.c_str(), &db)) {
-        std::cerr << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
+// readerCount == 0 keeps the classic single-connection setup. With readers, the get*
+// queries run on read-only WAL connections in parallel while writes serialize on the writer.
+bool DatabaseManager::openDatabase(size_t readerCount) {
+    return pool.open(dbName, readerCount);
+}
+
+// The in-memory copy lives in the memdb VFS under a name unique to this manager, so the
+// writer and reader connections of the pool all share it.
+bool DatabaseManager::openInMemory(size_t readerCount, std::chrono::milliseconds flushInterval) {
+    std::ostringstream memoryName;
+    memoryName << "file:/students-" << static_cast<const void*>(this) << "?vfs=memdb";
+
+    if (!pool.open(memoryName.str(), readerCount)) {
         return false;
     }
+
+    // Not marked in-memory until loaded, so closing after a failed load cannot flush
+    // the empty copy over the file on disk
+    if (!loadFromDisk()) {
+        closeDatabase();
+        return false;
+    }
+    inMemory = true;
+
+    if (flushInterval.count() > 0) {
+        stopFlusher = false;
+        flusher = std::thread(&DatabaseManager::runPeriodicFlush, this, flushInterval);
+    }
     return true;
 }
 
+// The write-back copies everything in one step: the throttling of BackupOptions is
+// there for hot backups and would only stretch out shutdown and periodic flushes.
+bool DatabaseManager::flushToDisk() {
+    if (!inMemory) {
+        return true;
+    }
+    BackupOptions options;
+    options.pagesPerStep = -1;
+    options.sleepMs = 0;
+    return backupToFile(dbName, options);
+}
+
 void DatabaseManager::closeDatabase() {
-    if (db) {
-        sqlite3_close(db);
-        db = nullptr;
+    writeQueue.stop();
+    if (inMemory && pool.isOpen()) {
+        stopPeriodicFlush();
+        if (!flushToDisk()) {
+            std::cerr << "Failed to write in-memory database back to " << dbName << std::endl;
+        }
     }
+    inMemory = false;
+    pool.close();
 }
 
-// Create all tables (students, courses, enrollments)
+// Copy the on-disk database (if any) into the freshly opened in-memory writer.
+bool DatabaseManager::loadFromDisk() {
+    std::error_code ec;
+    if (!std::filesystem::exists(dbName, ec)) {
+        if (ec) {
+            std::cerr << "Failed to check for " << dbName << ": " << ec.message() << std::endl;
+            return false;
+        }
+        // Nothing on disk yet: start empty and create the file on the first flush
+        return true;
+    }
+
+    // The file exists, so failing to open it is an error rather than a fresh start
+    sqlite3* source = nullptr;
+    if (sqlite3_open_v2(dbName.c_str(), &source, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to open " << dbName << " for loading: " << sqlite3_errmsg(source) << std::endl;
+        sqlite3_close(source);
+        return false;
+    }
+
+    auto conn = pool.acquireWriter();
+    sqlite3_backup* backup = sqlite3_backup_init(conn.get(), "main", source, "main");
+    if (!backup) {
+        std::cerr << "Failed to load database into memory: " << sqlite3_errmsg(conn.get()) << std::endl;
+        sqlite3_close(source);
+        return false;
+    }
+
+    int rc = sqlite3_backup_step(backup, -1);
+    sqlite3_backup_finish(backup);
+    sqlite3_close(source);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to load database into memory: " << sqlite3_errstr(rc) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void DatabaseManager::runPeriodicFlush(std::chrono::milliseconds interval) {
+    std::unique_lock<std::mutex> lock(flusherMutex);
+    while (!flusherWake.wait_for(lock, interval, [this] { return stopFlusher; })) {
+        lock.unlock();
+        if (!flushToDisk()) {
+            std::cerr << "Periodic flush to " << dbName << " failed" << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+void DatabaseManager::stopPeriodicFlush() {
+    if (!flusher.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(flusherMutex);
+        stopFlusher = true;
+    }
+    flusherWake.notify_all();
+    flusher.join();
+}
+
+// Create all tables (students, courses, enrollments), their secondary indexes and,
+// when SQLite has FTS5, the search tables
 bool DatabaseManager::createTables() {
-    return createStudentTable() && createCourseTable() && createEnrollmentTable();
+    return createStudentTable() && createCourseTable() && createEnrollmentTable() && createIndexes()
+        && (!searchSupported() || createSearchTables());
 }
 
 bool DatabaseManager::createStudentTable() {
-    const char* createTableSQL = R"(
-        CREATE TABLE IF NOT EXISTS students (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            first_name TEXT NOT NULL,
-            last_name TEXT NOT NULL,
-            phone_number TEXT NOT NULL,
-            department TEXT NOT NULL
-        );
-    )";
-    return executeSQL(createTableSQL);
+    return executeSQL(Table<StudentRow>::createSql());
 }
 
 bool DatabaseManager::createCourseTable() {
-    const char* createTableSQL = R"(
-        CREATE TABLE IF NOT EXISTS courses (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            course_name TEXT NOT NULL,
-            department TEXT NOT NULL,
-            credits INTEGER NOT NULL
-        );
-    )";
-    return executeSQL(createTableSQL);
+    return executeSQL(Table<CourseRow>::createSql());
 }
 
-// Create enrollment table (many-to-many relation)
 bool DatabaseManager::createEnrollmentTable() {
-    const char* createTableSQL = R"(
-        CREATE TABLE IF NOT EXISTS enrollments (
-            student_id INTEGER NOT NULL,
-            course_id INTEGER NOT NULL,
-            PRIMARY KEY (student_id, course_id),
-            FOREIGN KEY (student_id) REFERENCES students(id),
-            FOREIGN KEY (course_id) REFERENCES courses(id)
+    return executeSQL(Table<EnrollmentRow>::createSql());
+}
+
+// Secondary indexes: (course_id, student_id) covers course roster lookups,
+// department serves department-level queries on students.
+bool DatabaseManager::createIndexes() {
+    const char* createIndexesSQL = R"(
+        CREATE INDEX IF NOT EXISTS idx_enrollments_course ON enrollments (course_id, student_id);
+        CREATE INDEX IF NOT EXISTS idx_students_department ON students (department);
+    )";
+    return executeSQL(createIndexesSQL);
+}
+
+// External-content FTS5 tables over student names/departments and course names. Triggers
+// keep them in sync with every insert, update and delete; a search table created on an
+// already populated database is rebuilt once from its content table. The update triggers
+// only fire for indexed columns, so e.g. phone number upserts leave the index alone; they
+// are dropped and recreated so databases with the older catch-all triggers pick that up.
+bool DatabaseManager::createSearchTables() {
+    bool studentsIndexed = tableExists("students_fts");
+    bool coursesIndexed = tableExists("courses_fts");
+
+    const char* createSearchSQL = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS students_fts USING fts5(
+            first_name, last_name, department,
+            content='students', content_rowid='id', prefix='2 3'
         );
+        CREATE TRIGGER IF NOT EXISTS students_fts_insert AFTER INSERT ON students BEGIN
+            INSERT INTO students_fts (rowid, first_name, last_name, department)
+            VALUES (new.id, new.first_name, new.last_name, new.department);
+        END;
+        CREATE TRIGGER IF NOT EXISTS students_fts_delete AFTER DELETE ON students BEGIN
+            INSERT INTO students_fts (students_fts, rowid, first_name, last_name, department)
+            VALUES ('delete', old.id, old.first_name, old.last_name, old.department);
+        END;
+        DROP TRIGGER IF EXISTS students_fts_update;
+        CREATE TRIGGER students_fts_update AFTER UPDATE OF first_name, last_name, department ON students BEGIN
+            INSERT INTO students_fts (students_fts, rowid, first_name, last_name, department)
+            VALUES ('delete', old.id, old.first_name, old.last_name, old.department);
+            INSERT INTO students_fts (rowid, first_name, last_name, department)
+            VALUES (new.id, new.first_name, new.last_name, new.department);
+        END;
+
+        CREATE VIRTUAL TABLE IF NOT EXISTS courses_fts USING fts5(
+            course_name,
+            content='courses', content_rowid='id', prefix='2 3'
+        );
+        CREATE TRIGGER IF NOT EXISTS courses_fts_insert AFTER INSERT ON courses BEGIN
+            INSERT INTO courses_fts (rowid, course_name) VALUES (new.id, new.course_name);
+        END;
+        CREATE TRIGGER IF NOT EXISTS courses_fts_delete AFTER DELETE ON courses BEGIN
+            INSERT INTO courses_fts (courses_fts, rowid, course_name) VALUES ('delete', old.id, old.course_name);
+        END;
+        DROP TRIGGER IF EXISTS courses_fts_update;
+        CREATE TRIGGER courses_fts_update AFTER UPDATE OF course_name ON courses BEGIN
+            INSERT INTO courses_fts (courses_fts, rowid, course_name) VALUES ('delete', old.id, old.course_name);
+            INSERT INTO courses_fts (rowid, course_name) VALUES (new.id, new.course_name);
+        END;
     )";
-    return executeSQL(createTableSQL);
+    if (!executeSQL(createSearchSQL)) {
+        return false;
+    }
+
+    if (!studentsIndexed && !executeSQL("INSERT INTO students_fts (students_fts) VALUES ('rebuild');")) {
+        return false;
+    }
+    if (!coursesIndexed && !executeSQL("INSERT INTO courses_fts (courses_fts) VALUES ('rebuild');")) {
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseManager::tableExists(const std::string& name) {
+    auto conn = pool.acquireWriter();
+    auto stmt = conn.prepare("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;");
+    if (!stmt) {
+        return false;
+    }
+    sqlite3_bind_text(stmt.get(), 1, name.c_str(), -1, SQLITE_STATIC);
+    return sqlite3_step(stmt.get()) == SQLITE_ROW;
 }
 
 bool DatabaseManager::insertStudent(const std::string& firstName, const std::string& lastName,
     const std::string& phoneNumber, const std::string& department) {
-    std::string sql = "INSERT INTO students (first_name, last_name, phone_number, department) VALUES (?, ?, ?, ?);";
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(Table<StudentRow>::insertSql());
+    if (!stmt) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, firstName.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, lastName.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, phoneNumber.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, department.c_str(), -1, SQLITE_STATIC);
+    Table<StudentRow>::bind(stmt.get(), StudentRow{ 0, firstName, lastName, phoneNumber, department });
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
         std::cerr << "Failed to insert student: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
-
-    sqlite3_finalize(stmt);
     return true;
 }
 
 bool DatabaseManager::getAllStudents() {
-    std::string sql = "SELECT * FROM students";
-    sqlite3_stmt* stmt;
+    return getAllStudents([](const StudentRow& row) {
+        std::cout << "ID: " << row.id << ", Name: " << row.firstName << " " << row.lastName
+            << ", Phone: " << row.phoneNumber << ", Department: " << row.department << '\n';
+        return true;
+    });
+}
 
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+bool DatabaseManager::getAllStudents(const RowVisitor<StudentRow>& visitor) {
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    auto stmt = conn.prepare(Table<StudentRow>::selectSql());
+    if (!stmt) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const char* firstName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        const char* lastName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        const char* phoneNumber = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        const char* department = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+    return visitRows<StudentRow>(db, stmt.get(), visitor, [](sqlite3_stmt* row) {
+        return Table<StudentRow>::extract(row);
+    });
+}
+
+// Keyset page over students ordered by id: "WHERE id > afterId" seeks straight into
+// the primary key, so every page costs the same regardless of how deep it is.
+bool DatabaseManager::getStudentsPage(PageCursor& cursor, int limit, const RowVisitor<StudentRow>& visitor) {
+    if (limit <= 0) {
+        std::cerr << "Page limit must be positive, got " << limit << std::endl;
+        return false;
+    }
+    if (cursor.done) {
+        return true;
+    }
+
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
 
-        std::cout << "ID: " << id << ", Name: " << firstName << " " << lastName
-            << ", Phone: " << phoneNumber << ", Department: " << department << std::endl;
+    static const std::string sql = Table<StudentRow>::selectSql() + " WHERE id > ? ORDER BY id LIMIT ?;";
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
     }
 
-    sqlite3_finalize(stmt);
-    return true;
+    sqlite3_bind_int(stmt.get(), 1, cursor.afterId);
+    sqlite3_bind_int(stmt.get(), 2, limit);
+
+    return visitPage<StudentRow>(db, stmt.get(), cursor, limit, visitor, [](sqlite3_stmt* row) {
+        return Table<StudentRow>::extract(row);
+    });
 }
 
 bool DatabaseManager::insertCourse(const std::string& courseName, const std::string& department, int credits) {
-    std::string sql = "INSERT INTO courses (course_name, department, credits) VALUES (?, ?, ?);";
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(Table<CourseRow>::insertSql());
+    if (!stmt) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
 
-    sqlite3_bind_text(stmt, 1, courseName.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, department.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 3, credits);
+    Table<CourseRow>::bind(stmt.get(), CourseRow{ 0, courseName, department, credits });
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
         std::cerr << "Failed to insert course: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    courseRosterCache.erase(static_cast<int>(sqlite3_last_insert_rowid(db)));
     return true;
 }
 
+void DatabaseManager::enableWriteBehind(std::chrono::milliseconds maxDelay, size_t maxBatch) {
+    writeQueue.start(pool, maxDelay, maxBatch);
+}
+
+std::future<bool> DatabaseManager::insertStudentAsync(std::string firstName, std::string lastName,
+    std::string phoneNumber, std::string department) {
+    auto insert = [this, firstName = std::move(firstName), lastName = std::move(lastName),
+        phoneNumber = std::move(phoneNumber), department = std::move(department)]() {
+        return insertStudent(firstName, lastName, phoneNumber, department);
+    };
+
+    if (writeQueue.isRunning()) {
+        return writeQueue.submit(std::move(insert));
+    }
+    std::promise<bool> done;
+    done.set_value(insert());
+    return done.get_future();
+}
+
+std::future<bool> DatabaseManager::insertCourseAsync(std::string courseName, std::string department, int credits) {
+    auto insert = [this, courseName = std::move(courseName), department = std::move(department), credits]() {
+        return insertCourse(courseName, department, credits);
+    };
+
+    if (writeQueue.isRunning()) {
+        return writeQueue.submit(std::move(insert));
+    }
+    std::promise<bool> done;
+    done.set_value(insert());
+    return done.get_future();
+}
+
 bool DatabaseManager::getAllCourses() {
-    std::string sql = "SELECT * FROM courses";
-    sqlite3_stmt* stmt;
+    return getAllCourses([](const CourseRow& row) {
+        std::cout << "ID: " << row.id << ", Course: " << row.courseName
+            << ", Department: " << row.department << ", Credits: " << row.credits << '\n';
+        return true;
+    });
+}
 
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+bool DatabaseManager::getAllCourses(const RowVisitor<CourseRow>& visitor) {
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    auto stmt = conn.prepare(Table<CourseRow>::selectSql());
+    if (!stmt) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const char* courseName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        const char* department = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        int credits = sqlite3_column_int(stmt, 3);
+    return visitRows<CourseRow>(db, stmt.get(), visitor, [](sqlite3_stmt* row) {
+        return Table<CourseRow>::extract(row);
+    });
+}
 
-        std::cout << "ID: " << id << ", Course: " << courseName
-            << ", Department: " << department << ", Credits: " << credits << std::endl;
+bool DatabaseManager::getCoursesPage(PageCursor& cursor, int limit, const RowVisitor<CourseRow>& visitor) {
+    if (limit <= 0) {
+        std::cerr << "Page limit must be positive, got " << limit << std::endl;
+        return false;
+    }
+    if (cursor.done) {
+        return true;
     }
 
-    sqlite3_finalize(stmt);
-    return true;
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    static const std::string sql = Table<CourseRow>::selectSql() + " WHERE id > ? ORDER BY id LIMIT ?;";
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_int(stmt.get(), 1, cursor.afterId);
+    sqlite3_bind_int(stmt.get(), 2, limit);
+
+    return visitPage<CourseRow>(db, stmt.get(), cursor, limit, visitor, [](sqlite3_stmt* row) {
+        return Table<CourseRow>::extract(row);
+    });
 }
 
 bool DatabaseManager::enrollStudentInCourse(int studentId, int courseId) {
-    std::string sql = "INSERT INTO enrollments (student_id, course_id) VALUES (?, ?);";
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
 
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(Table<EnrollmentRow>::insertSql());
+    if (!stmt) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
 
-    sqlite3_bind_int(stmt, 1, studentId);
-    sqlite3_bind_int(stmt, 2, courseId);
+    Table<EnrollmentRow>::bind(stmt.get(), EnrollmentRow{ studentId, courseId });
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
+    if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
         std::cerr << "Failed to enroll student: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    invalidateRosters(studentId, courseId);
     return true;
 }
 
-bool DatabaseManager::getStudentsInCourse(int courseId) {
-    std::string sql = "SELECT students.first_name, students.last_name FROM students "
-        "JOIN enrollments ON students.id = enrollments.student_id "
-        "WHERE enrollments.course_id = ?;";
-    sqlite3_stmt* stmt;
+// Enroll many (studentId, courseId) pairs in a single transaction, reusing one prepared statement.
+// With ignoreDuplicates, pairs that are already enrolled are skipped instead of failing the batch.
+bool DatabaseManager::enrollStudentsInCourses(const std::vector<std::pair<int, int>>& enrollments, bool ignoreDuplicates) {
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
 
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare(ignoreDuplicates
+        ? Table<EnrollmentRow>::insertOrIgnoreSql()
+        : Table<EnrollmentRow>::insertSql());
+    if (!stmt) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
 
-    sqlite3_bind_int(stmt, 1, courseId);
+    if (!executeSQL("BEGIN TRANSACTION;")) {
+        return false;
+    }
+
+    for (const auto& enrollment : enrollments) {
+        Table<EnrollmentRow>::bind(stmt.get(), EnrollmentRow{ enrollment.first, enrollment.second });
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const char* firstName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-        const char* lastName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+            std::cerr << "Failed to enroll student " << enrollment.first << " in course "
+                << enrollment.second << ": " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_reset(stmt.get());
+            executeSQL("ROLLBACK;");
+            return false;
+        }
+        sqlite3_reset(stmt.get());
+    }
 
-        std::cout << "Student: " << firstName << " " << lastName << std::endl;
+    if (!executeSQL("COMMIT;")) {
+        executeSQL("ROLLBACK;");
+        return false;
     }
 
-    sqlite3_finalize(stmt);
+    for (const auto& enrollment : enrollments) {
+        invalidateRosters(enrollment.first, enrollment.second);
+    }
+    return true;
+}
+
+bool DatabaseManager::getStudentsInCourse(int courseId) {
+    return getStudentsInCourse(courseId, [](const EnrolledStudentRow& row) {
+        std::cout << "Student: " << row.firstName << " " << row.lastName << '\n';
+        return true;
+    });
+}
+
+// With the roster cache enabled, a miss loads the full roster once and later calls are
+// served from memory until an enrollment touching this course invalidates it.
+bool DatabaseManager::getStudentsInCourse(int courseId, const RowVisitor<EnrolledStudentRow>& visitor) {
+    if (!courseRosterCache.enabled()) {
+        return queryStudentsInCourse(courseId, visitor);
+    }
+
+    auto roster = courseRosterCache.get(courseId);
+    if (!roster) {
+        uint64_t version = courseRosterCache.version();
+        auto loaded = std::make_shared<std::vector<CachedEnrolledStudent>>();
+        bool ok = queryStudentsInCourse(courseId, [&loaded](const EnrolledStudentRow& row) {
+            loaded->push_back({ row.studentId, std::string(row.firstName), std::string(row.lastName) });
+            return true;
+        });
+        if (!ok) {
+            return false;
+        }
+        courseRosterCache.put(courseId, loaded, version);
+        roster = std::move(loaded);
+    }
+
+    for (const auto& student : *roster) {
+        if (!visitor({ student.studentId, student.firstName, student.lastName })) {
+            break;
+        }
+    }
     return true;
 }
 
+bool DatabaseManager::queryStudentsInCourse(int courseId, const RowVisitor<EnrolledStudentRow>& visitor) {
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    auto stmt = conn.prepare("SELECT students.id, students.first_name, students.last_name FROM students "
+        "JOIN enrollments ON students.id = enrollments.student_id "
+        "WHERE enrollments.course_id = ?;");
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_int(stmt.get(), 1, courseId);
+
+    return visitRows<EnrolledStudentRow>(db, stmt.get(), visitor, [](sqlite3_stmt* row) {
+        return EnrolledStudentRow{ sqlite3_column_int(row, 0), columnText(row, 1), columnText(row, 2) };
+    });
+}
+
 bool DatabaseManager::getCoursesForStudent(int studentId) {
-    std::string sql = "SELECT courses.course_name FROM courses "
+    return getCoursesForStudent(studentId, [](const EnrolledCourseRow& row) {
+        std::cout << "Course: " << row.courseName << '\n';
+        return true;
+    });
+}
+
+bool DatabaseManager::getCoursesForStudent(int studentId, const RowVisitor<EnrolledCourseRow>& visitor) {
+    if (!studentCourseCache.enabled()) {
+        return queryCoursesForStudent(studentId, visitor);
+    }
+
+    auto courses = studentCourseCache.get(studentId);
+    if (!courses) {
+        uint64_t version = studentCourseCache.version();
+        auto loaded = std::make_shared<std::vector<CachedEnrolledCourse>>();
+        bool ok = queryCoursesForStudent(studentId, [&loaded](const EnrolledCourseRow& row) {
+            loaded->push_back({ row.courseId, std::string(row.courseName) });
+            return true;
+        });
+        if (!ok) {
+            return false;
+        }
+        studentCourseCache.put(studentId, loaded, version);
+        courses = std::move(loaded);
+    }
+
+    for (const auto& course : *courses) {
+        if (!visitor({ course.courseId, course.courseName })) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool DatabaseManager::queryCoursesForStudent(int studentId, const RowVisitor<EnrolledCourseRow>& visitor) {
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    auto stmt = conn.prepare("SELECT courses.id, courses.course_name FROM courses "
         "JOIN enrollments ON courses.id = enrollments.course_id "
-        "WHERE enrollments.student_id = ?;";
+        "WHERE enrollments.student_id = ?;");
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_int(stmt.get(), 1, studentId);
+
+    return visitRows<EnrolledCourseRow>(db, stmt.get(), visitor, [](sqlite3_stmt* row) {
+        return EnrolledCourseRow{ sqlite3_column_int(row, 0), columnText(row, 1) };
+    });
+}
+
+bool DatabaseManager::searchStudents(const std::string& query, int limit, const RowVisitor<StudentRow>& visitor) {
+    if (!searchSupported()) {
+        std::cerr << "Search is unavailable: SQLite was built without FTS5" << std::endl;
+        return false;
+    }
+    if (limit <= 0) {
+        std::cerr << "Search limit must be positive, got " << limit << std::endl;
+        return false;
+    }
+
+    std::string match = toPrefixMatch(query);
+    if (match.empty()) {
+        return true;
+    }
+
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    static const std::string sql = "SELECT " + Table<StudentRow>::columnList(true, "students")
+        + " FROM students_fts JOIN students ON students.id = students_fts.rowid"
+        + " WHERE students_fts MATCH ? ORDER BY rank LIMIT ?;";
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_text(stmt.get(), 1, match.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt.get(), 2, limit);
+
+    return visitRows<StudentRow>(db, stmt.get(), visitor, [](sqlite3_stmt* row) {
+        return Table<StudentRow>::extract(row);
+    });
+}
+
+bool DatabaseManager::searchCourses(const std::string& query, int limit, const RowVisitor<CourseRow>& visitor) {
+    if (!searchSupported()) {
+        std::cerr << "Search is unavailable: SQLite was built without FTS5" << std::endl;
+        return false;
+    }
+    if (limit <= 0) {
+        std::cerr << "Search limit must be positive, got " << limit << std::endl;
+        return false;
+    }
+
+    std::string match = toPrefixMatch(query);
+    if (match.empty()) {
+        return true;
+    }
+
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    static const std::string sql = "SELECT " + Table<CourseRow>::columnList(true, "courses")
+        + " FROM courses_fts JOIN courses ON courses.id = courses_fts.rowid"
+        + " WHERE courses_fts MATCH ? ORDER BY rank LIMIT ?;";
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_text(stmt.get(), 1, match.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt.get(), 2, limit);
+
+    return visitRows<CourseRow>(db, stmt.get(), visitor, [](sqlite3_stmt* row) {
+        return Table<CourseRow>::extract(row);
+    });
+}
+
+// Bound the number of cached rosters per direction; 0 turns the cache off.
+void DatabaseManager::enableRosterCache(size_t capacity) {
+    courseRosterCache.setCapacity(capacity);
+    studentCourseCache.setCapacity(capacity);
+    courseRosterCache.clear();
+    studentCourseCache.clear();
+}
+
+void DatabaseManager::invalidateRosters(int studentId, int courseId) {
+    courseRosterCache.erase(courseId);
+    studentCourseCache.erase(studentId);
+}
+
+// Refreshes a copy and publishes it, so readers still scanning the previous snapshot
+// are never touched; the copy shares all filled segments with the original. A reset
+// while the refresh runs (an import changing rows) bumps the epoch, and a refresh
+// built on the pre-reset rows is thrown away and redone from the new base.
+bool DatabaseManager::refreshStudentSnapshot() {
+    const int maxAttempts = 3;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        std::shared_ptr<StudentSnapshot> next;
+        uint64_t epoch;
+        {
+            std::lock_guard<std::mutex> lock(snapshotMutex);
+            next = std::make_shared<StudentSnapshot>(*snapshot);
+            epoch = snapshotEpoch;
+        }
+
+        {
+            auto conn = pool.acquireReader();
+            if (!next->refresh(conn.get())) {
+                return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        if (snapshotEpoch == epoch) {
+            snapshot = std::move(next);
+            return true;
+        }
+    }
+    std::cerr << "Student snapshot kept being reset during refresh" << std::endl;
+    return false;
+}
+
+std::shared_ptr<const StudentSnapshot> DatabaseManager::studentSnapshot() const {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    return snapshot;
+}
+
+// CSV gets a header row of column names. The binary format starts with the magic
+// "SQLX", a version byte and the length-prefixed column names, then one tagged row per
+// record (see writeBinaryRow) and a terminating zero byte.
+// The SELECT runs inside a read transaction on a reader connection, so in pooled (WAL)
+// mode the export sees one consistent snapshot without blocking writers.
+bool DatabaseManager::exportTable(const std::string& table, const std::string& path, ExportFormat format) {
+    if (table != "students" && table != "courses" && table != "enrollments") {
+        std::cerr << "Unknown table: " << table << std::endl;
+        return false;
+    }
+
+    BufferedFileWriter writer(path);
+    if (!writer.isOpen()) {
+        std::cerr << "Failed to open export file: " << path << std::endl;
+        return false;
+    }
+
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    std::string sql = "SELECT * FROM " + table + ";";
     sqlite3_stmt* stmt;
 
+    if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to start read transaction: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
     if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
         return false;
     }
 
-    sqlite3_bind_int(stmt, 1, studentId);
+    int columnCount = sqlite3_column_count(stmt);
+    if (format == ExportFormat::Csv) {
+        for (int i = 0; i < columnCount; ++i) {
+            if (i > 0) {
+                writer.put(',');
+            }
+            writeCsvField(writer, sqlite3_column_name(stmt, i));
+        }
+        writer.write("\r\n");
+    }
+    else {
+        writer.write("SQLX", 4);
+        writer.put(1);
+        writer.writeUint32(static_cast<uint32_t>(columnCount));
+        for (int i = 0; i < columnCount; ++i) {
+            std::string_view name = sqlite3_column_name(stmt, i);
+            writer.writeUint32(static_cast<uint32_t>(name.size()));
+            writer.write(name);
+        }
+    }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const char* courseName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (format == ExportFormat::Csv) {
+            writeCsvRow(writer, stmt, columnCount);
+        }
+        else {
+            writeBinaryRow(writer, stmt, columnCount);
+        }
+    }
 
-        std::cout << "Course: " << courseName << std::endl;
+    if (format == ExportFormat::Binary) {
+        writer.put(0);
     }
 
     sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to export table: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    if (!writer.commit()) {
+        std::cerr << "Failed to write export file: " << path << std::endl;
+        return false;
+    }
     return true;
 }
 
+bool DatabaseManager::backupToFile(const std::string& path, const BackupOptions& options) {
+    sqlite3* destination = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &destination, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        std::cerr << "Can't open backup database: " << sqlite3_errmsg(destination) << std::endl;
+        sqlite3_close(destination);
+        return false;
+    }
+
+    bool ok = runBackup(destination, options);
+    sqlite3_close(destination);
+    return ok;
+}
+
+std::unique_ptr<DatabaseManager> DatabaseManager::createMemorySnapshot(const BackupOptions& options) {
+    auto snapshotManager = std::make_unique<DatabaseManager>(":memory:");
+    if (!snapshotManager->openDatabase()) {
+        return nullptr;
+    }
+
+    auto conn = snapshotManager->pool.acquireWriter();
+    if (!runBackup(conn.get(), options)) {
+        return nullptr;
+    }
+
+    if (sqlite3_exec(conn.get(), "PRAGMA query_only = ON;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to mark snapshot read-only: " << sqlite3_errmsg(conn.get()) << std::endl;
+        return nullptr;
+    }
+    return snapshotManager;
+}
+
+// The writer connection is the backup source: changes written through it are applied to
+// the backup in place, whereas writes from any other connection would restart the copy.
+// The writer lease is only held for one step at a time, so inserts interleave with the backup.
+bool DatabaseManager::runBackup(sqlite3* destination, const BackupOptions& options) {
+    sqlite3_backup* backup;
+    {
+        auto conn = pool.acquireWriter();
+        backup = sqlite3_backup_init(destination, "main", conn.get(), "main");
+    }
+    if (!backup) {
+        std::cerr << "Failed to start backup: " << sqlite3_errmsg(destination) << std::endl;
+        return false;
+    }
+
+    int rc;
+    do {
+        int remaining;
+        int total;
+        {
+            auto conn = pool.acquireWriter();
+            rc = sqlite3_backup_step(backup, options.pagesPerStep);
+            remaining = sqlite3_backup_remaining(backup);
+            total = sqlite3_backup_pagecount(backup);
+        }
+
+        if (options.progress) {
+            options.progress(remaining, total);
+        }
+
+        if ((rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) && options.sleepMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.sleepMs));
+        }
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+    {
+        auto conn = pool.acquireWriter();
+        sqlite3_backup_finish(backup);
+    }
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Backup failed: " << sqlite3_errstr(rc) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void DatabaseManager::enableQueryStats(std::chrono::microseconds slowQueryThreshold) {
+    queryStats.setSlowQueryThreshold(slowQueryThreshold);
+    pool.forEachConnection([this](sqlite3* connection) {
+        queryStats.attach(connection);
+    });
+}
+
+void DatabaseManager::printQueryStats(std::ostream& out) {
+    auto conn = pool.acquireReader();
+    queryStats.report(out, conn.get());
+}
+
 bool DatabaseManager::executeSQL(const std::string& sql) {
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
+
     char* errMsg = nullptr;
     if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
         std::cerr << "SQL error: " << errMsg << std::endl;
@@ -258,3 +1162,107 @@ bool DatabaseManager::insertFromTxtFile(const std::string& filename) {
     file.close();
     return true;
 }
+
+// Rows are upserted in transactions of importBatchSize so a large file neither holds one
+// huge transaction nor pays a commit per row.
+bool DatabaseManager::importStudentsFromTxtFile(const std::string& filename, const std::string& naturalKey) {
+    const size_t importBatchSize = 10000;
+
+    if (!Table<StudentRow>::hasColumn(naturalKey)) {
+        std::cerr << "Unknown natural key column: " << naturalKey << std::endl;
+        return false;
+    }
+
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Failed to open import file: " << filename << std::endl;
+        return false;
+    }
+
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
+
+    std::string indexSQL = "CREATE UNIQUE INDEX IF NOT EXISTS idx_students_" + naturalKey
+        + "_unique ON students (" + naturalKey + ");";
+    if (!executeSQL(indexSQL)) {
+        std::cerr << "Could not create a unique index on " << naturalKey
+            << "; remove duplicate values before importing." << std::endl;
+        return false;
+    }
+
+    auto stmt = conn.prepare(Table<StudentRow>::upsertSql(naturalKey));
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    size_t lineNumber = 0;
+    size_t written = 0;
+    size_t unchanged = 0;
+    size_t skipped = 0;
+    size_t inBatch = 0;
+    std::string line;
+
+    if (!executeSQL("BEGIN TRANSACTION;")) {
+        return false;
+    }
+
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (trim(line).empty()) {
+            continue;
+        }
+
+        std::string_view fields[4];
+        if (!parseStudentLine(line, fields)) {
+            std::cerr << filename << ":" << lineNumber << ": expected first,last,phone,department" << std::endl;
+            ++skipped;
+            continue;
+        }
+
+        Table<StudentRow>::bind(stmt.get(), StudentRow{ 0, fields[0], fields[1], fields[2], fields[3] });
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) {
+            std::cerr << "Failed to import student at line " << lineNumber << ": " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_reset(stmt.get());
+            executeSQL("ROLLBACK;");
+            return false;
+        }
+        sqlite3_reset(stmt.get());
+
+        if (sqlite3_changes(db) > 0) {
+            ++written;
+        }
+        else {
+            ++unchanged;
+        }
+
+        if (++inBatch == importBatchSize) {
+            // A failed COMMIT leaves the transaction open on the shared writer
+            if (!executeSQL("COMMIT;")) {
+                executeSQL("ROLLBACK;");
+                return false;
+            }
+            if (!executeSQL("BEGIN TRANSACTION;")) {
+                return false;
+            }
+            inBatch = 0;
+        }
+    }
+
+    if (!executeSQL("COMMIT;")) {
+        executeSQL("ROLLBACK;");
+        return false;
+    }
+
+    // Updated names invalidate cached rosters, and the snapshot only picks up new ids
+    if (written > 0) {
+        courseRosterCache.clear();
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        snapshot = std::make_shared<StudentSnapshot>();
+        ++snapshotEpoch;
+    }
+
+    std::cout << "Imported " << filename << ": " << written << " written, " << unchanged
+        << " unchanged, " << skipped << " skipped" << std::endl;
+    return true;
+}
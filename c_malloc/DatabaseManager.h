@@ -1,39 +1,245 @@
 #ifndef DATABASEMANAGER_H
 #define DATABASEMANAGER_H
 
+#include "ConnectionPool.h"
+#include "LruCache.h"
+#include "QueryStats.h"
+#include "StudentSnapshot.h"
+#include "TableSchema.h"
+#include "WriteBehindQueue.h"
 #include <sqlite3.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Row views handed to query visitors. The string_views point into SQLite's
+// column buffers and are only valid for the duration of the visitor call.
+// StudentRow, CourseRow and EnrollmentRow are also the table rows described
+// by the TableSchema specializations below.
+struct StudentRow {
+    int id;
+    std::string_view firstName;
+    std::string_view lastName;
+    std::string_view phoneNumber;
+    std::string_view department;
+};
+
+struct CourseRow {
+    int id;
+    std::string_view courseName;
+    std::string_view department;
+    int credits;
+};
+
+struct EnrollmentRow {
+    int studentId;
+    int courseId;
+};
+
+struct EnrolledStudentRow {
+    int studentId;
+    std::string_view firstName;
+    std::string_view lastName;
+};
+
+struct EnrolledCourseRow {
+    int courseId;
+    std::string_view courseName;
+};
+
+template <>
+struct TableSchema<StudentRow> {
+    static constexpr const char* name = "students";
+    static constexpr auto key = autoKey("id", &StudentRow::id);
+    static constexpr auto columns = std::make_tuple(
+        column("first_name", "TEXT NOT NULL", &StudentRow::firstName),
+        column("last_name", "TEXT NOT NULL", &StudentRow::lastName),
+        column("phone_number", "TEXT NOT NULL", &StudentRow::phoneNumber),
+        column("department", "TEXT NOT NULL", &StudentRow::department));
+    static constexpr const char* constraints = "";
+    static constexpr const char* options = "";
+};
+
+template <>
+struct TableSchema<CourseRow> {
+    static constexpr const char* name = "courses";
+    static constexpr auto key = autoKey("id", &CourseRow::id);
+    static constexpr auto columns = std::make_tuple(
+        column("course_name", "TEXT NOT NULL", &CourseRow::courseName),
+        column("department", "TEXT NOT NULL", &CourseRow::department),
+        column("credits", "INTEGER NOT NULL", &CourseRow::credits));
+    static constexpr const char* constraints = "";
+    static constexpr const char* options = "";
+};
+
+// Many-to-many relation. WITHOUT ROWID stores rows directly in the primary key b-tree,
+// so per-student lookups need no extra rowid hop.
+template <>
+struct TableSchema<EnrollmentRow> {
+    static constexpr const char* name = "enrollments";
+    static constexpr NoKey key{};
+    static constexpr auto columns = std::make_tuple(
+        column("student_id", "INTEGER NOT NULL", &EnrollmentRow::studentId),
+        column("course_id", "INTEGER NOT NULL", &EnrollmentRow::courseId));
+    static constexpr const char* constraints =
+        "PRIMARY KEY (student_id, course_id), "
+        "FOREIGN KEY (student_id) REFERENCES students(id), "
+        "FOREIGN KEY (course_id) REFERENCES courses(id)";
+    static constexpr const char* options = "WITHOUT ROWID";
+};
+
+// Keyset pagination state. Start from a default cursor and pass it to successive
+// page calls; afterId is the continuation token (last id returned so far).
+// Page calls fail for a limit below 1.
+struct PageCursor {
+    int afterId = 0;
+    bool done = false;
+};
+
+enum class ExportFormat {
+    Csv,
+    Binary
+};
+
+// Incremental online backup settings: copy pagesPerStep pages, then pause sleepMs
+// so writers can make progress. progress receives (remaining, total) pages after each step.
+struct BackupOptions {
+    int pagesPerStep = 256;
+    int sleepMs = 10;
+    std::function<void(int remaining, int total)> progress;
+};
 
 class DatabaseManager {
 public:
+    // Called once per result row; return false to stop stepping early.
+    template <typename Row>
+    using RowVisitor = std::function<bool(const Row&)>;
+
     DatabaseManager(const std::string& dbName);
     ~DatabaseManager();
 
-    bool openDatabase();
+    bool openDatabase(size_t readerCount = 0);
+    // Load the database file into RAM and work there. Changes are written back by
+    // flushToDisk, on closeDatabase, and every flushInterval when it is non-zero.
+    bool openInMemory(size_t readerCount = 0, std::chrono::milliseconds flushInterval = std::chrono::milliseconds(0));
+    bool flushToDisk();
     void closeDatabase();
 
     bool createTables();
     bool insertStudent(const std::string& firstName, const std::string& lastName,
         const std::string& phoneNumber, const std::string& department);
     bool getAllStudents();
+    bool getAllStudents(const RowVisitor<StudentRow>& visitor);
+    bool getStudentsPage(PageCursor& cursor, int limit, const RowVisitor<StudentRow>& visitor);
     bool insertFromTxtFile(const std::string& filename);
+    // Idempotent import of "first,last,phone,department" lines keyed on a unique natural key:
+    // new keys are inserted, changed rows updated, identical rows skipped.
+    bool importStudentsFromTxtFile(const std::string& filename, const std::string& naturalKey = "phone_number");
 
     bool insertCourse(const std::string& courseName, const std::string& department, int credits);
     bool getAllCourses();
+    bool getAllCourses(const RowVisitor<CourseRow>& visitor);
+    bool getCoursesPage(PageCursor& cursor, int limit, const RowVisitor<CourseRow>& visitor);
+
+    // Queue inserts for a background writer that group-commits them, up to maxBatch rows
+    // per transaction and holding a row back at most maxDelay. Stopped (and drained) by
+    // closeDatabase.
+    void enableWriteBehind(std::chrono::milliseconds maxDelay, size_t maxBatch = 1000);
+    // The futures complete once the row is committed. Without write-behind the insert
+    // runs on the calling thread and the future is already ready.
+    std::future<bool> insertStudentAsync(std::string firstName, std::string lastName,
+        std::string phoneNumber, std::string department);
+    std::future<bool> insertCourseAsync(std::string courseName, std::string department, int credits);
+
     bool enrollStudentInCourse(int studentId, int courseId);
+    bool enrollStudentsInCourses(const std::vector<std::pair<int, int>>& enrollments, bool ignoreDuplicates = false);
 
     bool getStudentsInCourse(int courseId);
+    bool getStudentsInCourse(int courseId, const RowVisitor<EnrolledStudentRow>& visitor);
     bool getCoursesForStudent(int studentId);
+    bool getCoursesForStudent(int studentId, const RowVisitor<EnrolledCourseRow>& visitor);
+
+    // Ranked full-text search; every word of the query matches as a name prefix.
+    // Fails for a limit below 1 or when SQLite was built without FTS5.
+    bool searchStudents(const std::string& query, int limit, const RowVisitor<StudentRow>& visitor);
+    bool searchCourses(const std::string& query, int limit, const RowVisitor<CourseRow>& visitor);
+
+    // In-process LRU cache for roster lookups, invalidated by enrollments and new courses.
+    void enableRosterCache(size_t capacity);
+
+    // Columnar copy of students for analytics; refresh appends rows added since the last call.
+    // Snapshots are immutable once published, so a held pointer stays valid and unchanged
+    // while other threads refresh.
+    bool refreshStudentSnapshot();
+    std::shared_ptr<const StudentSnapshot> studentSnapshot() const;
+
+    // Stream a whole table to a file from a single read transaction.
+    bool exportTable(const std::string& table, const std::string& path, ExportFormat format);
+
+    // Hot backups through the SQLite online backup API; ingest keeps running between steps.
+    bool backupToFile(const std::string& path, const BackupOptions& options = BackupOptions());
+    // Read-only in-memory copy that supports the same queries; nullptr on failure.
+    std::unique_ptr<DatabaseManager> createMemorySnapshot(const BackupOptions& options = BackupOptions());
+
+    // Trace every statement on all pooled connections; call right after opening.
+    void enableQueryStats(std::chrono::microseconds slowQueryThreshold);
+    void printQueryStats(std::ostream& out);
 
 private:
+    struct CachedEnrolledStudent {
+        int studentId;
+        std::string firstName;
+        std::string lastName;
+    };
+
+    struct CachedEnrolledCourse {
+        int courseId;
+        std::string courseName;
+    };
+
+    bool queryStudentsInCourse(int courseId, const RowVisitor<EnrolledStudentRow>& visitor);
+    bool queryCoursesForStudent(int studentId, const RowVisitor<EnrolledCourseRow>& visitor);
+    void invalidateRosters(int studentId, int courseId);
+
+    bool runBackup(sqlite3* destination, const BackupOptions& options);
+    bool loadFromDisk();
+    void runPeriodicFlush(std::chrono::milliseconds interval);
+    void stopPeriodicFlush();
+
     bool executeSQL(const std::string& sql);
     bool createStudentTable();
     bool createCourseTable();
     bool createEnrollmentTable();
+    bool createIndexes();
+    bool createSearchTables();
+    bool tableExists(const std::string& name);
 
 private:
     std::string dbName;
-    sqlite3* db;
+    ConnectionPool pool;
+    LruCache<int, std::vector<CachedEnrolledStudent>> courseRosterCache;
+    LruCache<int, std::vector<CachedEnrolledCourse>> studentCourseCache;
+    std::shared_ptr<const StudentSnapshot> snapshot;
+    uint64_t snapshotEpoch;     // Bumped whenever snapshot is reset because rows changed
+    mutable std::mutex snapshotMutex;
+    QueryStats queryStats;
+    WriteBehindQueue writeQueue;
+
+    bool inMemory;
+    std::thread flusher;
+    std::mutex flusherMutex;
+    std::condition_variable flusherWake;
+    bool stopFlusher;
 };
 
 #endif
@@ -1,16 +1,103 @@
 #include "DatabaseServer.h"
+#include "CsvRowStream.h"
+#include "FileUpload.h"
+#include "HttpCompression.h"
+#include "JsonReader.h"
+#include "JsonRowStream.h"
+#include "JsonWriter.h"
 #include "sqlite3.h"
-#include <fstream>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
-#include <nlohmann/json.hpp>
+#include <memory>
 #include "httplib.h"
 #include <string>
 
-using json = nlohmann::json;
 using namespace httplib;
 
+namespace {
+    const int maxPageSize = 1000;
+    const int rowsPerChunk = 256;
+    const size_t bulkBatchSize = 1000;
+    const size_t defaultResponseCacheEntries = 256;
+    const int defaultCompressionLevel = 6;
+    const size_t defaultCompressionMinBytes = 1024;
+    const uint64_t defaultMaxUploadBytes = uint64_t(2) * 1024 * 1024 * 1024;
+
+    // httplib compresses bare "application/json" bodies by itself whenever it is built
+    // with CPPHTTPLIB_ZLIB_SUPPORT, ignoring size and level. With the charset parameter
+    // it leaves JSON alone and the server's own negotiation is the only one applied.
+    const char* const jsonContentType = "application/json; charset=utf-8";
+
+    // Non-negative integer query parameter; absent parameters keep `value`.
+    bool readIntParam(const Request& req, const char* key, int& value) {
+        if (!req.has_param(key)) {
+            return true;
+        }
+        std::string text = req.get_param_value(key);
+        int parsed = 0;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), parsed);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size() || parsed < 0) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    // If-None-Match holds "*" or a comma separated list of (possibly weak) ETags.
+    // "*" only matches when the caller knows the resource exists (matchAny).
+    bool etagMatches(const Request& req, const std::string& etag, bool matchAny) {
+        if (!req.has_header("If-None-Match")) {
+            return false;
+        }
+        std::string header = req.get_header_value("If-None-Match");
+        size_t pos = 0;
+        while (pos < header.size()) {
+            size_t end = header.find(',', pos);
+            if (end == std::string::npos) {
+                end = header.size();
+            }
+            std::string_view candidate(header.data() + pos, end - pos);
+            while (!candidate.empty() && candidate.front() == ' ') {
+                candidate.remove_prefix(1);
+            }
+            while (!candidate.empty() && candidate.back() == ' ') {
+                candidate.remove_suffix(1);
+            }
+            if (candidate.substr(0, 2) == "W/") {
+                candidate.remove_prefix(2);
+            }
+            if ((matchAny && candidate == "*") || candidate == etag) {
+                return true;
+            }
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    // Reader lease and statement kept alive across content provider calls.
+    // The statement is declared last so it is reset before the lease is returned.
+    struct BookStream {
+        BookStream(ConnectionPool::Lease conn, ScopedStatement stmt)
+            : conn(std::move(conn)), stmt(std::move(stmt)) {}
+
+        ConnectionPool::Lease conn;
+        ScopedStatement stmt;
+        bool started = false;
+        std::string chunk;      // Reused for every chunk of the response
+        std::unique_ptr<StreamCompressor> compressor;
+        std::string compressed;
+    };
+}
+
 DatabaseServer::DatabaseServer(const std::string& dbName, int port)
-    : port(port), db(nullptr) {
+    : responseCache(defaultResponseCacheEntries), compressionLevel(defaultCompressionLevel),
+    compressionMinBytes(defaultCompressionMinBytes), uploadDirectory("."),
+    maxUploadBytes(defaultMaxUploadBytes), port(port) {
+    etagPrefix = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
     connectToDatabase(dbName);
     createTables();  
     setupRoutes();
@@ -18,203 +105,555 @@ DatabaseServer::DatabaseServer(const std::string& dbName, int port)
 }
 
 DatabaseServer::~DatabaseServer() {
-    if (db) {
-        sqlite3_close(db);  
-    }
+    pool.close();
 }
 
+// Every worker thread of the HTTP server can hold its own reader, so GET requests
+// never wait for each other; writes serialize on the pool's writer connection.
 void DatabaseServer::connectToDatabase(const std::string& dbName) {
-    if (sqlite3_open(dbName.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "Error opening database: " << sqlite3_errmsg(db) << std::endl;
+    if (!pool.open(dbName, static_cast<size_t>(CPPHTTPLIB_THREAD_POOL_COUNT))) {
+        std::cerr << "Error opening database: " << dbName << std::endl;
         exit(EXIT_FAILURE);  
     }
 }
 
 void DatabaseServer::createTables() {
-    const char* createBooksTableSQL = R"(
-        CREATE TABLE IF NOT EXISTS books (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            title TEXT NOT NULL,
-            author TEXT NOT NULL,
-            isbn TEXT NOT NULL,
-            year INTEGER NOT NULL,
-            publisher TEXT NOT NULL,
-            availability BOOLEAN NOT NULL
-        );
-    )";
-
-    executeSQL(createBooksTableSQL, "Error creating books table");
+    executeSQL(Table<BookRow>::createSql(), "Error creating books table");
 }
 
 void DatabaseServer::setupRoutes() {
     server.Get("/books", [this](const Request& req, Response& res) { handleGetBooks(req, res); });
-    server.Get("/book/<id>", [this](const Request& req, Response& res) { handleGetBookById(req, res); });
+    server.Get(R"(/book/(\d+))", [this](const Request& req, Response& res) { handleGetBookById(req, res); });
+    server.Post("/books/bulk", [this](const Request& req, Response& res, const ContentReader& reader) { handleBulkInsert(req, res, reader); });
     server.Post("/insert", [this](const Request& req, Response& res) { handleInsertBook(req, res); });
-    server.Post("/upload", [this](const Request& req, Response& res) { handleUploadFile(req, res); });
-    server.Put("/update/<id>", [this](const Request& req, Response& res) { handleUpdateBook(req, res); });
-    server.Delete("/delete/<id>", [this](const Request& req, Response& res) { handleDeleteBook(req, res); });
+    server.Post("/upload", [this](const Request& req, Response& res, const ContentReader& reader) { handleUploadFile(req, res, reader); });
+    server.Put(R"(/update/(\d+))", [this](const Request& req, Response& res) { handleUpdateBook(req, res); });
+    server.Delete(R"(/delete/(\d+))", [this](const Request& req, Response& res) { handleDeleteBook(req, res); });
 }
 
+// GET /books?limit=N&after_id=K returns one keyset page ordered by id, with the id to
+// continue from in X-Next-After-Id while more rows may follow. Without a limit the
+// whole table is streamed with chunked encoding while the rows are stepped.
 void DatabaseServer::handleGetBooks(const Request& req, Response& res) {
-    sqlite3_stmt* stmt = nullptr;
-    std::string sql = "SELECT * FROM books";
+    int afterId = 0;
+    int limit = 0;
+    if (!readIntParam(req, "after_id", afterId) || !readIntParam(req, "limit", limit)) {
+        handleError(res, 400, "after_id and limit must be non-negative integers");
+        return;
+    }
+
+    if (!req.has_param("limit")) {
+        // Streamed responses are too big to cache but still carry the version ETag
+        ContentEncoding encoding = responseEncoding(req);
+        uint64_t version = responseCache.version();
+        if (!sendIfNotModified(req, res, bookETag(version, encoding), true)) {
+            streamBooks(res, afterId, encoding, version);
+        }
+        return;
+    }
+    if (limit == 0 || limit > maxPageSize) {
+        handleError(res, 400, "limit must be between 1 and " + std::to_string(maxPageSize));
+        return;
+    }
+
+    std::string key = "books?after_id=" + std::to_string(afterId) + "&limit=" + std::to_string(limit);
+    serveBooks(req, res, key, [this, afterId, limit](CachedResponse& page, Response& res) {
+        auto conn = pool.acquireReader();
+        sqlite3* db = conn.get();
+
+        static const std::string sql = Table<BookRow>::selectSql() + " WHERE id > ? ORDER BY id LIMIT ?;";
+        auto stmt = conn.prepare(sql);
+        if (!stmt) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+            handleError(res, 500, "Failed to retrieve books");
+            return false;
+        }
 
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_bind_int(stmt.get(), 1, afterId);
+        sqlite3_bind_int(stmt.get(), 2, limit);
+
+        std::string& body = page.body;
+        body = "[";
+        int rows = 0;
+        int lastId = afterId;
+        while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+            if (rows++ > 0) {
+                body += ',';
+            }
+            lastId = sqlite3_column_int(stmt.get(), 0);
+            JsonRowWriter<BookRow>::append(body, stmt.get());
+        }
+        body += ']';
+
+        // A full page means there may be more; a short page is the last one
+        if (rows == limit) {
+            page.nextAfterId = std::to_string(lastId);
+        }
+        return true;
+    });
+}
+
+// The lease and statement move into shared state owned by the content provider, so the
+// reader stays checked out until the last chunk is written or the client goes away.
+// The ETag is set here because a compressor that fails to start drops the stream back
+// to identity, which is a different representation.
+void DatabaseServer::streamBooks(Response& res, int afterId, ContentEncoding encoding, uint64_t version) {
+    auto conn = pool.acquireReader();
+    sqlite3* db = conn.get();
+
+    static const std::string sql = Table<BookRow>::selectSql() + " WHERE id > ? ORDER BY id;";
+    auto stmt = conn.prepare(sql);
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         handleError(res, 500, "Failed to retrieve books");
         return;
     }
+    sqlite3_bind_int(stmt.get(), 1, afterId);
 
-    json books = json::array();
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        books.push_back(extractBookData(stmt));
+    auto stream = std::make_shared<BookStream>(std::move(conn), std::move(stmt));
+    if (encoding != ContentEncoding::Identity) {
+        stream->compressor = std::make_unique<StreamCompressor>(encoding, compressionLevel);
+        if (stream->compressor->isValid()) {
+            res.set_header("Content-Encoding", encodingName(encoding));
+        }
+        else {
+            std::cerr << "Failed to start books stream compressor, sending it uncompressed" << std::endl;
+            stream->compressor.reset();
+            encoding = ContentEncoding::Identity;
+        }
+        res.set_header("Vary", "Accept-Encoding");
     }
+    res.set_header("ETag", bookETag(version, encoding));
+    res.set_header("Cache-Control", "no-cache");
+
+    res.set_chunked_content_provider(jsonContentType, [stream](size_t, DataSink& sink) {
+        std::string& chunk = stream->chunk;
+        chunk.clear();
+        if (!stream->started) {
+            chunk += '[';
+        }
+
+        int rows = 0;
+        int rc = SQLITE_ROW;
+        while (rows < rowsPerChunk && (rc = sqlite3_step(stream->stmt.get())) == SQLITE_ROW) {
+            if (stream->started || rows > 0) {
+                chunk += ',';
+            }
+            JsonRowWriter<BookRow>::append(chunk, stream->stmt.get());
+            ++rows;
+        }
+        stream->started = true;
 
-    sqlite3_finalize(stmt);
-    res.set_content(books.dump(), "application/json");
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+            std::cerr << "Failed to stream books: " << sqlite3_errmsg(stream->conn.get()) << std::endl;
+            return false;
+        }
+        if (rc == SQLITE_DONE) {
+            chunk += ']';
+        }
+
+        if (stream->compressor) {
+            stream->compressed.clear();
+            if (!stream->compressor->compress(chunk, rc == SQLITE_DONE, stream->compressed)) {
+                std::cerr << "Failed to compress books stream" << std::endl;
+                return false;
+            }
+            sink.write(stream->compressed.data(), stream->compressed.size());
+        }
+        else {
+            sink.write(chunk.data(), chunk.size());
+        }
+        if (rc == SQLITE_DONE) {
+            sink.done();
+        }
+        return true;
+    });
 }
 
 void DatabaseServer::handleGetBookById(const Request& req, Response& res) {
     int id = std::stoi(req.matches[1]);
-    sqlite3_stmt* stmt = nullptr;
-    std::string sql = "SELECT * FROM books WHERE id = ?";
+    serveBooks(req, res, "book/" + std::to_string(id), [this, id](CachedResponse& book, Response& res) {
+        auto conn = pool.acquireReader();
+        sqlite3* db = conn.get();
+
+        static const std::string sql = Table<BookRow>::selectSql() + " WHERE id = ?;";
+        auto stmt = conn.prepare(sql);
+        if (!stmt) {
+            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+            handleError(res, 500, "Failed to retrieve book");
+            return false;
+        }
+
+        sqlite3_bind_int(stmt.get(), 1, id);
+        if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+            handleError(res, 404, "Book not found");
+            return false;
+        }
 
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-        handleError(res, 500, "Failed to retrieve book");
+        JsonRowWriter<BookRow>::append(book.body, stmt.get());
+        return true;
+    });
+}
+
+// The request body must be exactly one book object. Text fields of `book` view the
+// body or `scratch`, both of which outlive the statement step, so they bind as
+// SQLITE_STATIC without copies.
+bool DatabaseServer::parseBook(const std::string& body, BookRow& book, std::string& scratch, Response& res) {
+    JsonParseResult parsed = JsonRowReader<BookRow>::parse(body, book, scratch);
+    if (parsed.status == JsonParseStatus::Incomplete) {
+        handleError(res, 400, "Invalid request: unexpected end of JSON input");
+        return false;
+    }
+    if (parsed.status == JsonParseStatus::Error) {
+        handleError(res, 400, "Invalid request: " + parsed.error);
+        return false;
+    }
+    if (body.find_first_not_of(" \t\r\n", parsed.consumed) != std::string::npos) {
+        handleError(res, 400, "Invalid request: unexpected data after the JSON object");
+        return false;
+    }
+    return true;
+}
+
+void DatabaseServer::handleInsertBook(const Request& req, Response& res) {
+    BookRow book{};
+    std::string scratch;
+    if (!parseBook(req.body, book, scratch, res)) {
         return;
     }
 
-    sqlite3_bind_int(stmt, 1, id);
-    json book;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        book = extractBookData(stmt);
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
+
+    auto stmt = conn.prepare(Table<BookRow>::insertSql());
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        handleError(res, 500, "Failed to prepare SQL statement");
+        return;
     }
 
-    sqlite3_finalize(stmt);
+    Table<BookRow>::bind(stmt.get(), book);
 
-    if (book.empty()) {
-        handleError(res, 404, "Book not found");
+    if (sqlite3_step(stmt.get()) == SQLITE_DONE) {
+        invalidateBooks();
+        res.set_content("Book inserted successfully", "text/plain");
     }
     else {
-        res.set_content(book.dump(), "application/json");
+        std::cerr << "Failed to insert book: " << sqlite3_errmsg(db) << std::endl;
+        handleError(res, 500, "Error inserting book");
     }
 }
 
-void DatabaseServer::handleInsertBook(const Request& req, Response& res) {
-    try {
-        json body = json::parse(req.body);
-        std::string title = body["title"];
-        std::string author = body["author"];
-        std::string isbn = body["isbn"];
-        int year = body["year"];
-        std::string publisher = body["publisher"];
-        bool availability = body["availability"];
-
-        std::string sql = "INSERT INTO books (title, author, isbn, year, publisher, availability) VALUES (?, ?, ?, ?, ?, ?);";
-        sqlite3_stmt* stmt = nullptr;
-
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare SQL statement");
-        }
+void DatabaseServer::handleUpdateBook(const Request& req, Response& res) {
+    int id = std::stoi(req.matches[1]);
+    BookRow book{};
+    std::string scratch;
+    if (!parseBook(req.body, book, scratch, res)) {
+        return;
+    }
+    book.id = id;
 
-        sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, author.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, isbn.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 4, year);
-        sqlite3_bind_text(stmt, 5, publisher.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 6, availability ? 1 : 0);
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
 
-        if (sqlite3_step(stmt) == SQLITE_DONE) {
-            res.set_content("Book inserted successfully", "text/plain");
-        }
-        else {
-            throw std::runtime_error("Error inserting book");
-        }
+    auto stmt = conn.prepare(Table<BookRow>::updateSql());
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        handleError(res, 500, "Failed to prepare SQL statement");
+        return;
+    }
 
-        sqlite3_finalize(stmt);
+    Table<BookRow>::bindForUpdate(stmt.get(), book);
+
+    if (sqlite3_step(stmt.get()) == SQLITE_DONE) {
+        invalidateBooks();
+        res.set_content("Book updated successfully", "text/plain");
     }
-    catch (const std::exception& e) {
-        handleError(res, 400, std::string("Invalid request: ") + e.what());
+    else {
+        std::cerr << "Failed to update book: " << sqlite3_errmsg(db) << std::endl;
+        handleError(res, 500, "Error updating book");
     }
 }
 
-void DatabaseServer::handleUpdateBook(const Request& req, Response& res) {
-    int id = std::stoi(req.matches[1]);
-    try {
-        json body = json::parse(req.body);
-        std::string title = body["title"];
-        std::string author = body["author"];
-        std::string isbn = body["isbn"];
-        int year = body["year"];
-        std::string publisher = body["publisher"];
-        bool availability = body["availability"];
-
-        std::string sql = "UPDATE books SET title = ?, author = ?, isbn = ?, year = ?, publisher = ?, availability = ? WHERE id = ?;";
-        sqlite3_stmt* stmt = nullptr;
-
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare SQL statement");
-        }
+// POST /books/bulk takes a JSON array of books or NDJSON. Items are parsed as the body
+// arrives and inserted in transactions of bulkBatchSize; a malformed stream stops reading.
+void DatabaseServer::handleBulkInsert(const Request&, Response& res, const ContentReader& reader) {
+    JsonRowStream<BookRow> stream;
+    BatchInserter<BookRow> inserter(pool, bulkBatchSize);
 
-        sqlite3_bind_text(stmt, 1, title.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, author.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, isbn.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 4, year);
-        sqlite3_bind_text(stmt, 5, publisher.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 6, availability ? 1 : 0);
-        sqlite3_bind_int(stmt, 7, id);
+    auto onRow = [this, &inserter](size_t index, const BookRow& book) { addBulkBook(inserter, index, book); };
+    auto onError = [&inserter](size_t index, const std::string& error) { inserter.reject(index, error); };
 
-        if (sqlite3_step(stmt) == SQLITE_DONE) {
-            res.set_content("Book updated successfully", "text/plain");
+    bool wellFormed = reader([&](const char* data, size_t length) {
+        return stream.feed(std::string_view(data, length), onRow, onError);
+    });
+    wellFormed = wellFormed && stream.finish();
+    sendBulkResult(res, inserter, stream.itemCount(), wellFormed, stream.error());
+}
+
+// POST /upload?import=books loads an uploaded CSV (header row naming the book columns)
+// or JSON/NDJSON file into the books table while it is still being received. Nothing
+// is written to disk besides the database. The format comes from ?format=csv|json,
+// else from the file name extension, else from the Content-Type of a raw body.
+void DatabaseServer::handleImportBooks(const Request& req, Response& res, const ContentReader& reader) {
+    ImportFormat format = ImportFormat::Unknown;
+    if (req.has_param("format")) {
+        std::string name = req.get_param_value("format");
+        format = name == "csv" ? ImportFormat::Csv : name == "json" ? ImportFormat::Json : ImportFormat::Unknown;
+        if (format == ImportFormat::Unknown) {
+            handleError(res, 400, "format must be csv or json");
+            return;
         }
-        else {
-            throw std::runtime_error("Error updating book");
+    }
+
+    JsonRowStream<BookRow> jsonStream;
+    CsvRowStream<BookRow> csvStream;
+    BatchInserter<BookRow> inserter(pool, bulkBatchSize);
+
+    auto onRow = [this, &inserter](size_t index, const BookRow& book) { addBulkBook(inserter, index, book); };
+    auto onError = [&inserter](size_t index, const std::string& error) { inserter.reject(index, error); };
+    auto feed = [&](const char* data, size_t length) {
+        std::string_view chunk(data, length);
+        return format == ImportFormat::Csv
+            ? csvStream.feed(chunk, onRow, onError)
+            : jsonStream.feed(chunk, onRow, onError);
+    };
+
+    bool received = false;
+    bool started = false;
+    std::string requestError;
+    if (req.is_multipart_form_data()) {
+        bool inFile = false;
+        received = reader(
+            [&](const MultipartFormData& part) {
+                inFile = part.name == "file";
+                if (!inFile) {
+                    return true;
+                }
+                if (started) {
+                    requestError = "Only one file can be imported per request";
+                    return false;
+                }
+                started = true;
+                if (format == ImportFormat::Unknown) {
+                    format = importFormatFromName(part.filename);
+                }
+                if (format == ImportFormat::Unknown) {
+                    requestError = "Cannot tell the file format; name it .csv/.json/.ndjson or pass ?format=";
+                    return false;
+                }
+                return true;
+            },
+            [&](const char* data, size_t length) {
+                return !inFile || feed(data, length);
+            });
+    }
+    else {
+        if (format == ImportFormat::Unknown) {
+            std::string contentType = req.get_header_value("Content-Type");
+            format = contentType.find("csv") != std::string::npos ? ImportFormat::Csv
+                : contentType.find("json") != std::string::npos ? ImportFormat::Json
+                : ImportFormat::Unknown;
+        }
+        if (format == ImportFormat::Unknown) {
+            handleError(res, 400, "Cannot tell the file format; send text/csv or application/json or pass ?format=");
+            return;
         }
+        started = true;
+        received = reader(feed);
+    }
+
+    if (!started) {
+        handleError(res, 400, "No file provided");
+        return;
+    }
 
-        sqlite3_finalize(stmt);
+    if (format == ImportFormat::Csv) {
+        bool wellFormed = received && csvStream.finish(onRow, onError);
+        sendBulkResult(res, inserter, csvStream.itemCount(), wellFormed,
+            requestError.empty() ? csvStream.error() : requestError);
     }
-    catch (const std::exception& e) {
-        handleError(res, 400, std::string("Invalid request: ") + e.what());
+    else if (format == ImportFormat::Json) {
+        bool wellFormed = received && jsonStream.finish();
+        sendBulkResult(res, inserter, jsonStream.itemCount(), wellFormed,
+            requestError.empty() ? jsonStream.error() : requestError);
+    }
+    else {
+        handleError(res, 400, requestError);
     }
 }
 
+DatabaseServer::ImportFormat DatabaseServer::importFormatFromName(const std::string& name) {
+    std::string extension = std::filesystem::path(name).extension().string();
+    for (char& c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (extension == ".csv") {
+        return ImportFormat::Csv;
+    }
+    if (extension == ".json" || extension == ".ndjson" || extension == ".jsonl") {
+        return ImportFormat::Json;
+    }
+    return ImportFormat::Unknown;
+}
+
+// Batches commit while the body is still arriving; readers must not keep serving
+// cached pages from before a commit
+void DatabaseServer::addBulkBook(BatchInserter<BookRow>& inserter, size_t index, const BookRow& book) {
+    size_t before = inserter.insertedCount();
+    inserter.add(index, book);
+    if (inserter.insertedCount() != before) {
+        invalidateBooks();
+    }
+}
+
+// Commits the last batch and lists every item with its new id or the reason it was
+// rejected; a malformed stream answers 400, but batches committed before it are kept.
+void DatabaseServer::sendBulkResult(Response& res, BatchInserter<BookRow>& inserter, size_t itemCount,
+    bool wellFormed, const std::string& streamError) {
+    size_t before = inserter.insertedCount();
+    inserter.flush();
+    if (inserter.insertedCount() != before) {
+        invalidateBooks();
+    }
+
+    const auto& results = inserter.results();
+    std::string body = "{\"inserted\":";
+    json_writer::appendValue(body, static_cast<int64_t>(inserter.insertedCount()));
+    body += ",\"failed\":";
+    json_writer::appendValue(body, static_cast<int64_t>(itemCount - inserter.insertedCount()));
+    if (!wellFormed) {
+        body += ",\"error\":";
+        json_writer::appendString(body, streamError.empty() ? "failed to read request body" : streamError);
+    }
+    body += ",\"items\":[";
+    for (size_t i = 0; i < itemCount; ++i) {
+        body += i == 0 ? "{\"index\":" : ",{\"index\":";
+        json_writer::appendValue(body, static_cast<int64_t>(i));
+        if (i < results.size() && results[i].error.empty() && results[i].id != 0) {
+            body += ",\"id\":";
+            json_writer::appendValue(body, results[i].id);
+        }
+        else {
+            body += ",\"error\":";
+            json_writer::appendString(body, i < results.size() && !results[i].error.empty() ? results[i].error : "not inserted");
+        }
+        body += '}';
+    }
+    body += "]}";
+
+    res.status = wellFormed ? 200 : 400;
+    res.set_content(body, jsonContentType);
+}
 
 void DatabaseServer::handleDeleteBook(const Request& req, Response& res) {
     int id = std::stoi(req.matches[1]);
-    std::string sql = "DELETE FROM books WHERE id = ?;";
-    sqlite3_stmt* stmt = nullptr;
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
 
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    auto stmt = conn.prepare("DELETE FROM books WHERE id = ?;");
+    if (!stmt) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
         handleError(res, 500, "Failed to prepare delete statement");
         return;
     }
 
-    sqlite3_bind_int(stmt, 1, id);
-    if (sqlite3_step(stmt) == SQLITE_DONE) {
+    sqlite3_bind_int(stmt.get(), 1, id);
+    if (sqlite3_step(stmt.get()) == SQLITE_DONE) {
+        invalidateBooks();
         res.set_content("Book deleted successfully", "text/plain");
     }
     else {
         handleError(res, 500, "Error deleting book");
     }
-
-    sqlite3_finalize(stmt);
 }
 
-void DatabaseServer::handleUploadFile(const Request& req, Response& res) {
-    if (req.has_file("file")) {
-        const auto& file = req.get_file_value("file");
-        std::ofstream out(file.filename, std::ios::binary);
-
-        if (!out) {
-            handleError(res, 500, "Failed to write file");
+// POST /upload streams the multipart "file" field straight to disk through FileUpload,
+// so memory use stays at one receive buffer however large the file is.
+// ?checksum=crc32 reports the CRC-32 of the data in X-Upload-CRC32; ?crc32=<hex>
+// also rejects the upload when it does not match.
+void DatabaseServer::handleUploadFile(const Request& req, Response& res, const ContentReader& reader) {
+    if (req.has_param("import")) {
+        if (req.get_param_value("import") != "books") {
+            handleError(res, 400, "Only import=books is supported");
             return;
         }
+        handleImportBooks(req, res, reader);
+        return;
+    }
+    if (!req.is_multipart_form_data()) {
+        handleError(res, 400, "Expected a multipart/form-data upload");
+        return;
+    }
 
-        out.write(file.content.data(), file.content.size());
-        res.set_content("File uploaded successfully", "text/plain");
+    uint32_t expectedCrc = 0;
+    bool verifyChecksum = req.has_param("crc32");
+    if (verifyChecksum) {
+        std::string text = req.get_param_value("crc32");
+        auto result = std::from_chars(text.data(), text.data() + text.size(), expectedCrc, 16);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+            handleError(res, 400, "crc32 must be a hexadecimal CRC-32");
+            return;
+        }
     }
-    else {
+    bool computeChecksum = verifyChecksum || req.get_param_value("checksum") == "crc32";
+
+    FileUpload upload(uploadDirectory, maxUploadBytes, computeChecksum);
+    bool inFile = false;
+    bool duplicate = false;
+
+    bool received = reader(
+        [&](const MultipartFormData& part) {
+            inFile = part.name == "file";
+            if (!inFile) {
+                return true;
+            }
+            if (upload.started()) {
+                duplicate = true;
+                return false;
+            }
+            return upload.begin(part.filename);
+        },
+        [&](const char* data, size_t length) {
+            return !inFile || upload.write(data, length);
+        });
+
+    if (duplicate) {
+        handleError(res, 400, "Only one file can be uploaded per request");
+        return;
+    }
+    if (!upload.error().empty()) {
+        handleError(res, upload.errorStatus(), upload.error());
+        return;
+    }
+    if (!received) {
+        handleError(res, 400, "Malformed multipart upload");
+        return;
+    }
+    if (!upload.started()) {
         handleError(res, 400, "No file provided");
+        return;
+    }
+    if (verifyChecksum && upload.checksum() != expectedCrc) {
+        handleError(res, 422, "Checksum mismatch");
+        return;
+    }
+    if (!upload.commit()) {
+        handleError(res, upload.errorStatus(), upload.error());
+        return;
+    }
+
+    if (computeChecksum) {
+        char hex[9];
+        std::snprintf(hex, sizeof(hex), "%08x", upload.checksum());
+        res.set_header("X-Upload-CRC32", hex);
     }
+    res.set_content("File uploaded successfully: " + upload.filename() + " (" + std::to_string(upload.size()) + " bytes)", "text/plain");
+}
+
+void DatabaseServer::setUploadLimits(const std::string& directory, uint64_t maxBytes) {
+    uploadDirectory = directory;
+    maxUploadBytes = maxBytes;
 }
 
 void DatabaseServer::handleError(Response& res, int status, const std::string& message) {
@@ -222,19 +661,115 @@ void DatabaseServer::handleError(Response& res, int status, const std::string& m
     res.set_content(message, "text/plain");
 }
 
-json DatabaseServer::extractBookData(sqlite3_stmt* stmt) {
-    json book;
-    book["id"] = sqlite3_column_int(stmt, 0);
-    book["title"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-    book["author"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-    book["isbn"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-    book["year"] = sqlite3_column_int(stmt, 4);
-    book["publisher"] = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-    book["availability"] = sqlite3_column_int(stmt, 6) != 0;
-    return book;
+void DatabaseServer::setResponseCacheCapacity(size_t capacity) {
+    responseCache.setCapacity(capacity);
+}
+
+// zlib only accepts levels 1-9; anything below 1 turns compression off
+void DatabaseServer::setCompression(int level, size_t minBytes) {
+    compressionLevel = level < 0 ? 0 : (level > 9 ? 9 : level);
+    compressionMinBytes = minBytes;
+}
+
+ContentEncoding DatabaseServer::responseEncoding(const Request& req) const {
+    if (compressionLevel <= 0 || !req.has_header("Accept-Encoding")) {
+        return ContentEncoding::Identity;
+    }
+    return negotiateEncoding(req.get_header_value("Accept-Encoding"));
+}
+
+// Each encoding is its own representation and needs its own ETag
+std::string DatabaseServer::bookETag(uint64_t version, ContentEncoding encoding) const {
+    std::string etag = "\"" + etagPrefix + "-" + std::to_string(version);
+    if (encoding != ContentEncoding::Identity) {
+        etag += "-";
+        etag += encodingName(encoding);
+    }
+    return etag + "\"";
+}
+
+// Plain renderings are cached under `key` and compressed ones under "key;<encoding>",
+// so a miss for an encoding reuses the plain body instead of querying again.
+// render fills the plain body, or sets an error response and returns false. A
+// "If-None-Match: *" is only answered once a rendering exists, so missing books still 404.
+void DatabaseServer::serveBooks(const Request& req, Response& res, const std::string& key,
+    const std::function<bool(CachedResponse&, Response&)>& render) {
+    ContentEncoding encoding = responseEncoding(req);
+    uint64_t version = responseCache.version();
+    std::string etag = bookETag(version, encoding);
+    if (sendIfNotModified(req, res, etag, false)) {
+        return;
+    }
+
+    std::string encodedKey = encoding == ContentEncoding::Identity ? key : key + ";" + encodingName(encoding);
+    if (auto cached = responseCache.get(encodedKey)) {
+        if (!sendIfNotModified(req, res, etag, true)) {
+            sendCached(res, *cached, etag);
+        }
+        return;
+    }
+
+    std::shared_ptr<const CachedResponse> plain = encoding == ContentEncoding::Identity ? nullptr : responseCache.get(key);
+    if (!plain) {
+        auto rendered = std::make_shared<CachedResponse>();
+        if (!render(*rendered, res)) {
+            return;
+        }
+        responseCache.put(key, rendered, version);
+        plain = rendered;
+    }
+    if (sendIfNotModified(req, res, etag, true)) {
+        return;
+    }
+    if (encoding == ContentEncoding::Identity || plain->body.size() < compressionMinBytes) {
+        sendCached(res, *plain, etag);
+        return;
+    }
+
+    auto compressed = std::make_shared<CachedResponse>();
+    if (!compressBody(plain->body, encoding, compressionLevel, compressed->body)) {
+        sendCached(res, *plain, etag);
+        return;
+    }
+    compressed->nextAfterId = plain->nextAfterId;
+    compressed->contentEncoding = encodingName(encoding);
+    responseCache.put(encodedKey, compressed, version);
+    sendCached(res, *compressed, etag);
+}
+
+bool DatabaseServer::sendIfNotModified(const Request& req, Response& res, const std::string& etag, bool exists) {
+    if (!etagMatches(req, etag, exists)) {
+        return false;
+    }
+    res.status = 304;
+    res.set_header("ETag", etag);
+    return true;
+}
+
+void DatabaseServer::sendCached(Response& res, const CachedResponse& cached, const std::string& etag) {
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "no-cache");
+    if (!cached.nextAfterId.empty()) {
+        res.set_header("X-Next-After-Id", cached.nextAfterId);
+    }
+    if (compressionLevel > 0) {
+        res.set_header("Vary", "Accept-Encoding");
+    }
+    if (cached.contentEncoding) {
+        res.set_header("Content-Encoding", cached.contentEncoding);
+    }
+    res.set_content(cached.body, jsonContentType);
+}
+
+// Called after a write has committed; bumps the cache generation, i.e. the version
+void DatabaseServer::invalidateBooks() {
+    responseCache.clear();
 }
 
 void DatabaseServer::executeSQL(const std::string& sql, const std::string& errorMessage) {
+    auto conn = pool.acquireWriter();
+    sqlite3* db = conn.get();
+
     char* errMsg = nullptr;
     if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
         std::cerr << errorMessage << ": " << errMsg << std::endl;
@@ -248,7 +783,9 @@ void DatabaseServer::printRoutes() {
     // GET /books - Get all books
     std::cout << "\nGET /books               - Get all books" << std::endl;
     std::cout << "    - Retrieves a list of all books stored in the database." << std::endl;
+    std::cout << "    - Optional keyset paging: ?limit=N&after_id=K (next page id in the X-Next-After-Id header)." << std::endl;
     std::cout << "    - Example Request: curl -X GET http://localhost:<port>/books" << std::endl;
+    std::cout << "    - Example Request: curl -i -X GET \"http://localhost:<port>/books?limit=100&after_id=0\"" << std::endl;
 
     // GET /book/<id> - Get book by ID
     std::cout << "\nGET /book/<id>           - Get book by ID" << std::endl;
@@ -260,9 +797,18 @@ void DatabaseServer::printRoutes() {
     std::cout << "    - Adds a new book to the database. You need to send the book details in JSON format." << std::endl;
     std::cout << "    - Example Request: curl -X POST http://localhost:<port>/insert -d \"{\\\"title\\\": \\\"New Book\\\", \\\"author\\\": \\\"Author Name\\\", \\\"isbn\\\": \\\"1234567890\\\", \\\"year\\\": 2025, \\\"publisher\\\": \\\"Publisher Name\\\", \\\"availability\\\": true}\"" << std::endl;
 
+    // POST /books/bulk - Insert many books
+    std::cout << "\nPOST /books/bulk         - Insert many books" << std::endl;
+    std::cout << "    - Accepts a JSON array of books or NDJSON (one book per line), inserted in batched transactions." << std::endl;
+    std::cout << "    - Responds with the new id or an error for every item." << std::endl;
+    std::cout << "    - Example Request: curl -X POST http://localhost:<port>/books/bulk --data-binary @books.ndjson" << std::endl;
+
     // POST /upload - Upload a file
     std::cout << "\nPOST /upload             - Upload a file" << std::endl;
-    std::cout << "    - Allows file uploads using multipart/form-data." << std::endl;
+    std::cout << "    - Allows file uploads using multipart/form-data; the file is streamed to disk." << std::endl;
+    std::cout << "    - Add ?checksum=crc32 to get the CRC-32 back, or ?crc32=<hex> to have it verified." << std::endl;
+    std::cout << "    - With ?import=books a CSV or JSON/NDJSON file is loaded into the books table as it arrives." << std::endl;
+    std::cout << "    - Example Request: curl -X POST \"http://localhost:<port>/upload?import=books\" -F \"file=@/path/to/books.csv\"" << std::endl;
     std::cout << "    - Example Request: curl -X POST http://localhost:<port>/upload -F \"file=@/path/to/your/file.txt\"" << std::endl;
 
     // PUT /update/<id> - Update book by ID
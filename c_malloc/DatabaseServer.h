@@ -1,10 +1,43 @@
 #ifndef DATABASE_SERVER_H
 #define DATABASE_SERVER_H
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include "httplib.h"
 #include <sqlite3.h>
-#include <nlohmann/json.hpp>
+#include "BatchInserter.h"
+#include "ConnectionPool.h"
+#include "HttpCompression.h"
+#include "LruCache.h"
+#include "TableSchema.h"
+
+// One row of the books table; text fields view caller-owned or SQLite-owned buffers.
+struct BookRow {
+    int id;
+    std::string_view title;
+    std::string_view author;
+    std::string_view isbn;
+    int year;
+    std::string_view publisher;
+    bool availability;
+};
+
+template <>
+struct TableSchema<BookRow> {
+    static constexpr const char* name = "books";
+    static constexpr auto key = autoKey("id", &BookRow::id);
+    static constexpr auto columns = std::make_tuple(
+        column("title", "TEXT NOT NULL", &BookRow::title),
+        column("author", "TEXT NOT NULL", &BookRow::author),
+        column("isbn", "TEXT NOT NULL", &BookRow::isbn),
+        column("year", "INTEGER NOT NULL", &BookRow::year),
+        column("publisher", "TEXT NOT NULL", &BookRow::publisher),
+        column("availability", "BOOLEAN NOT NULL", &BookRow::availability));
+    static constexpr const char* constraints = "";
+    static constexpr const char* options = "";
+};
 
 
     class DatabaseServer {
@@ -15,7 +48,28 @@
 
         void run();
 
+        // Number of rendered GET responses kept in memory; 0 disables the cache.
+        void setResponseCacheCapacity(size_t capacity);
+        // gzip/deflate for clients that accept it (needs CPPHTTPLIB_ZLIB_SUPPORT).
+        // level 1-9 (out of range values are clamped) or 0 to disable; bodies below
+        // minBytes are sent as they are.
+        void setCompression(int level, size_t minBytes);
+        // Where /upload stores files and the largest file it accepts.
+        void setUploadLimits(const std::string& directory, uint64_t maxBytes);
+
     private:
+        struct CachedResponse {
+            std::string body;
+            std::string nextAfterId;    // X-Next-After-Id of a page, empty if none
+            const char* contentEncoding = nullptr;
+        };
+
+        enum class ImportFormat {
+            Unknown,
+            Csv,
+            Json
+        };
+
         // Private helper functions to interact with the database and handle requests
         void connectToDatabase(const std::string& dbName);
         void createTables();
@@ -26,15 +80,44 @@
 
         // HTTP request handlers
         void handleGetBooks(const httplib::Request& req, httplib::Response& res);
+        void streamBooks(httplib::Response& res, int afterId, ContentEncoding encoding, uint64_t version);
         void handleGetBookById(const httplib::Request& req, httplib::Response& res);
+        bool parseBook(const std::string& body, BookRow& book, std::string& scratch, httplib::Response& res);
         void handleInsertBook(const httplib::Request& req, httplib::Response& res);
+        void handleBulkInsert(const httplib::Request& req, httplib::Response& res, const httplib::ContentReader& reader);
+        void handleImportBooks(const httplib::Request& req, httplib::Response& res, const httplib::ContentReader& reader);
+        static ImportFormat importFormatFromName(const std::string& name);
+        void addBulkBook(BatchInserter<BookRow>& inserter, size_t index, const BookRow& book);
+        void sendBulkResult(httplib::Response& res, BatchInserter<BookRow>& inserter, size_t itemCount,
+            bool wellFormed, const std::string& streamError);
         void handleUpdateBook(const httplib::Request& req, httplib::Response& res);
         void handleDeleteBook(const httplib::Request& req, httplib::Response& res);
-        void handleUploadFile(const httplib::Request& req, httplib::Response& res);
+        void handleUploadFile(const httplib::Request& req, httplib::Response& res, const httplib::ContentReader& reader);
         void handleError(httplib::Response& res, int status, const std::string& message);
-        nlohmann::json extractBookData(sqlite3_stmt* stmt);
 
-        sqlite3* db;
+        // Book responses are versioned as a whole: every successful write starts a new
+        // version, which drops all cached responses and changes every ETag.
+        ContentEncoding responseEncoding(const httplib::Request& req) const;
+        std::string bookETag(uint64_t version, ContentEncoding encoding) const;
+        void serveBooks(const httplib::Request& req, httplib::Response& res, const std::string& key,
+            const std::function<bool(CachedResponse&, httplib::Response&)>& render);
+        // exists: the resource is known to exist, so "If-None-Match: *" matches as well
+        bool sendIfNotModified(const httplib::Request& req, httplib::Response& res, const std::string& etag, bool exists);
+        void sendCached(httplib::Response& res, const CachedResponse& cached, const std::string& etag);
+        void invalidateBooks();
+
+        // One read-only WAL connection per httplib worker plus the single writer
+        ConnectionPool pool;
+
+        // Keyed by route and parameters; the cache generation doubles as the books version
+        LruCache<std::string, CachedResponse> responseCache;
+        std::string etagPrefix;     // Differs per server start so old ETags never match
+
+        int compressionLevel;
+        size_t compressionMinBytes;
+
+        std::string uploadDirectory;
+        uint64_t maxUploadBytes;
 
         httplib::Server server;
 
@@ -0,0 +1,108 @@
+#include "FileUpload.h"
+#include <array>
+#include <atomic>
+#include <system_error>
+
+namespace {
+    const std::array<uint32_t, 256>& crcTable() {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> entries{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = (value & 1) ? 0xedb88320u ^ (value >> 1) : value >> 1;
+                }
+                entries[i] = value;
+            }
+            return entries;
+        }();
+        return table;
+    }
+
+    // Distinguishes concurrent uploads of the same file name
+    std::atomic<uint64_t> uploadCounter{ 0 };
+}
+
+FileUpload::FileUpload(const std::filesystem::path& directory, uint64_t maxBytes, bool computeChecksum)
+    : directory(directory), maxBytes(maxBytes), computeChecksum(computeChecksum),
+    written(0), crc(0xffffffffu), committed(false), status(200) {}
+
+FileUpload::~FileUpload() {
+    if (!committed) {
+        abort();
+    }
+}
+
+bool FileUpload::begin(const std::string& clientFilename) {
+    name = std::filesystem::path(clientFilename).filename().string();
+    if (name.empty() || name == "." || name == "..") {
+        return fail(400, "Invalid file name");
+    }
+
+    finalPath = directory / name;
+    partPath = directory / (name + "." + std::to_string(++uploadCounter) + ".part");
+    out.open(partPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return fail(500, "Failed to write file");
+    }
+    return true;
+}
+
+bool FileUpload::write(const char* data, size_t length) {
+    if (!out.is_open()) {
+        return false;
+    }
+    if (length > maxBytes - written) {
+        return fail(413, "File exceeds the maximum upload size of " + std::to_string(maxBytes) + " bytes");
+    }
+
+    if (computeChecksum) {
+        const auto& table = crcTable();
+        for (size_t i = 0; i < length; ++i) {
+            crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (crc >> 8);
+        }
+    }
+
+    out.write(data, static_cast<std::streamsize>(length));
+    if (!out) {
+        return fail(500, "Failed to write file");
+    }
+    written += length;
+    return true;
+}
+
+// rename() replaces an existing file of the same name in one step
+bool FileUpload::commit() {
+    if (!out.is_open()) {
+        return false;
+    }
+    out.close();
+    if (!out) {
+        return fail(500, "Failed to write file");
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(partPath, finalPath, ec);
+    if (ec) {
+        return fail(500, "Failed to store file: " + ec.message());
+    }
+    committed = true;
+    return true;
+}
+
+void FileUpload::abort() {
+    if (out.is_open()) {
+        out.close();
+    }
+    if (!partPath.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(partPath, ec);
+    }
+}
+
+bool FileUpload::fail(int httpStatus, std::string text) {
+    status = httpStatus;
+    message = std::move(text);
+    abort();
+    return false;
+}
@@ -0,0 +1,55 @@
+#ifndef FILE_UPLOAD_H
+#define FILE_UPLOAD_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// Streams one uploaded file to disk as its bytes arrive.
+// Data goes to "<name>.<n>.part" in the upload directory and is renamed to its final
+// name only by commit(), so readers never see a half-written file and a failed or
+// abandoned upload leaves nothing behind. The client's filename is reduced to its
+// last path component, so uploads cannot escape the directory.
+class FileUpload {
+public:
+    FileUpload(const std::filesystem::path& directory, uint64_t maxBytes, bool computeChecksum);
+    ~FileUpload();
+    FileUpload(const FileUpload&) = delete;
+    FileUpload& operator=(const FileUpload&) = delete;
+
+    bool begin(const std::string& clientFilename);
+    // False once the upload exceeds maxBytes or the disk write fails
+    bool write(const char* data, size_t length);
+    bool commit();
+    void abort();
+
+    bool started() const { return !finalPath.empty(); }
+    const std::string& filename() const { return name; }
+    uint64_t size() const { return written; }
+    uint32_t checksum() const { return crc ^ 0xffffffffu; }     // CRC-32 (IEEE)
+
+    // HTTP status and message describing why the upload failed
+    int errorStatus() const { return status; }
+    const std::string& error() const { return message; }
+
+private:
+    bool fail(int httpStatus, std::string text);
+
+    std::filesystem::path directory;
+    uint64_t maxBytes;
+    bool computeChecksum;
+
+    std::string name;
+    std::filesystem::path finalPath;
+    std::filesystem::path partPath;
+    std::ofstream out;
+    uint64_t written;
+    uint32_t crc;
+    bool committed;
+
+    int status;
+    std::string message;
+};
+
+#endif // FILE_UPLOAD_H
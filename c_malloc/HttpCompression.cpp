@@ -0,0 +1,167 @@
+#include "HttpCompression.h"
+#include <cstdlib>
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+#include <zlib.h>
+
+namespace {
+    std::string_view trim(std::string_view text) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+            text.remove_prefix(1);
+        }
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i) {
+            char x = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+            if (x != b[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+#endif
+
+ContentEncoding negotiateEncoding(const std::string& acceptEncoding) {
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+    double gzipQ = -1;
+    double deflateQ = -1;
+    double anyQ = -1;
+
+    std::string_view header(acceptEncoding);
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        std::string_view item = header.substr(0, comma);
+        header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+
+        size_t semicolon = item.find(';');
+        std::string_view coding = trim(item.substr(0, semicolon));
+        double q = 1;
+        if (semicolon != std::string_view::npos) {
+            std::string_view parameter = trim(item.substr(semicolon + 1));
+            if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+                q = std::strtod(std::string(parameter.substr(2)).c_str(), nullptr);
+            }
+        }
+
+        if (equalsIgnoreCase(coding, "gzip") || equalsIgnoreCase(coding, "x-gzip")) {
+            gzipQ = q;
+        }
+        else if (equalsIgnoreCase(coding, "deflate")) {
+            deflateQ = q;
+        }
+        else if (coding == "*") {
+            anyQ = q;
+        }
+    }
+
+    if (gzipQ < 0) {
+        gzipQ = anyQ;
+    }
+    if (deflateQ < 0) {
+        deflateQ = anyQ;
+    }
+    if (gzipQ > 0 && gzipQ >= deflateQ) {
+        return ContentEncoding::Gzip;
+    }
+    if (deflateQ > 0) {
+        return ContentEncoding::Deflate;
+    }
+#else
+    (void)acceptEncoding;
+#endif
+    return ContentEncoding::Identity;
+}
+
+const char* encodingName(ContentEncoding encoding) {
+    switch (encoding) {
+    case ContentEncoding::Gzip: return "gzip";
+    case ContentEncoding::Deflate: return "deflate";
+    default: return nullptr;
+    }
+}
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+// windowBits 15 + 16 writes a gzip wrapper; plain 15 writes the zlib format that
+// HTTP calls "deflate"
+struct StreamCompressor::State {
+    z_stream stream{};
+    bool valid = false;
+};
+
+StreamCompressor::StreamCompressor(ContentEncoding encoding, int level) : state(new State) {
+    int windowBits = encoding == ContentEncoding::Gzip ? 15 + 16 : 15;
+    state->valid = encoding != ContentEncoding::Identity
+        && deflateInit2(&state->stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+StreamCompressor::~StreamCompressor() {
+    if (state->valid) {
+        deflateEnd(&state->stream);
+    }
+    delete state;
+}
+
+bool StreamCompressor::isValid() const {
+    return state->valid;
+}
+
+bool StreamCompressor::compress(std::string_view input, bool last, std::string& out) {
+    if (!state->valid) {
+        return false;
+    }
+
+    z_stream& stream = state->stream;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int rc = Z_OK;
+    do {
+        // Grow the output in place and let deflate write straight into it
+        size_t offset = out.size();
+        size_t room = deflateBound(&stream, stream.avail_in) + 64;
+        out.resize(offset + room);
+        stream.next_out = reinterpret_cast<Bytef*>(&out[offset]);
+        stream.avail_out = static_cast<uInt>(room);
+
+        rc = deflate(&stream, flush);
+        out.resize(offset + room - stream.avail_out);
+        // Z_BUF_ERROR with output room left means deflate cannot make progress
+        if (rc == Z_STREAM_ERROR || (rc == Z_BUF_ERROR && stream.avail_out != 0)) {
+            return false;
+        }
+    } while (stream.avail_out == 0 || (last && rc != Z_STREAM_END));
+    return true;
+}
+#else
+struct StreamCompressor::State {};
+
+StreamCompressor::StreamCompressor(ContentEncoding, int) : state(new State) {}
+
+StreamCompressor::~StreamCompressor() {
+    delete state;
+}
+
+bool StreamCompressor::isValid() const {
+    return false;
+}
+
+bool StreamCompressor::compress(std::string_view, bool, std::string&) {
+    return false;
+}
+#endif
+
+bool compressBody(std::string_view input, ContentEncoding encoding, int level, std::string& out) {
+    StreamCompressor compressor(encoding, level);
+    out.clear();
+    return compressor.isValid() && compressor.compress(input, true, out);
+}
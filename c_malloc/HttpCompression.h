@@ -0,0 +1,43 @@
+#ifndef HTTP_COMPRESSION_H
+#define HTTP_COMPRESSION_H
+
+#include <string>
+#include <string_view>
+
+// Content-Encoding negotiation and zlib compression for server responses.
+// Compression is only compiled in with CPPHTTPLIB_ZLIB_SUPPORT (link with -lz);
+// without it every request negotiates to Identity.
+enum class ContentEncoding {
+    Identity,
+    Gzip,
+    Deflate
+};
+
+// Best of gzip/deflate allowed by an Accept-Encoding header, honouring q-values
+// (q=0 refuses an encoding, "*" stands for any). Gzip wins ties.
+ContentEncoding negotiateEncoding(const std::string& acceptEncoding);
+// Header value for Content-Encoding, nullptr for Identity
+const char* encodingName(ContentEncoding encoding);
+
+// Incremental compressor for chunked responses: each call emits everything it can,
+// flushing so that the client can decode every chunk as it arrives.
+class StreamCompressor {
+public:
+    StreamCompressor(ContentEncoding encoding, int level);
+    ~StreamCompressor();
+    StreamCompressor(const StreamCompressor&) = delete;
+    StreamCompressor& operator=(const StreamCompressor&) = delete;
+
+    bool isValid() const;
+    // Appends the compressed form of `input` to `out`; `last` finishes the stream.
+    bool compress(std::string_view input, bool last, std::string& out);
+
+private:
+    struct State;
+    State* state;
+};
+
+// One-shot compression of a whole body into `out`.
+bool compressBody(std::string_view input, ContentEncoding encoding, int level, std::string& out);
+
+#endif // HTTP_COMPRESSION_H
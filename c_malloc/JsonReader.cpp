@@ -0,0 +1,353 @@
+#include "JsonReader.h"
+#include <charconv>
+#include <climits>
+
+namespace json_reader {
+    namespace {
+        bool isWhitespace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        bool isNumberChar(char c) {
+            return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+        }
+
+        void appendUtf8(std::string& out, unsigned codePoint) {
+            if (codePoint < 0x80) {
+                out += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800) {
+                out += static_cast<char>(0xc0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3f));
+            }
+            else if (codePoint < 0x10000) {
+                out += static_cast<char>(0xe0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+                out += static_cast<char>(0x80 | (codePoint & 0x3f));
+            }
+            else {
+                out += static_cast<char>(0xf0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+                out += static_cast<char>(0x80 | (codePoint & 0x3f));
+            }
+        }
+    }
+
+    JsonParseStatus Cursor::fail(std::string text) {
+        message = std::move(text);
+        return JsonParseStatus::Error;
+    }
+
+    JsonParseStatus Cursor::peek(char& c) {
+        while (pos < input.size() && isWhitespace(input[pos])) {
+            ++pos;
+        }
+        if (pos == input.size()) {
+            return JsonParseStatus::Incomplete;
+        }
+        c = input[pos];
+        return JsonParseStatus::Ok;
+    }
+
+    JsonParseStatus Cursor::expect(char c) {
+        char next = 0;
+        JsonParseStatus status = peek(next);
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+        if (next != c) {
+            return fail(std::string("expected '") + c + "' at offset " + std::to_string(pos));
+        }
+        ++pos;
+        return JsonParseStatus::Ok;
+    }
+
+    // Plain strings are returned as views of the input. The first escape switches to
+    // copying the string, unescaped, onto the end of scratch.
+    JsonParseStatus Cursor::readString(std::string_view& value, std::string& scratch) {
+        JsonParseStatus status = expect('"');
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+
+        size_t start = pos;
+        while (pos < input.size() && input[pos] != '"' && input[pos] != '\\') {
+            if (static_cast<unsigned char>(input[pos]) < 0x20) {
+                return fail("control character in string at offset " + std::to_string(pos));
+            }
+            ++pos;
+        }
+        if (pos == input.size()) {
+            return JsonParseStatus::Incomplete;
+        }
+        if (input[pos] == '"') {
+            value = input.substr(start, pos - start);
+            ++pos;
+            return JsonParseStatus::Ok;
+        }
+
+        size_t scratchStart = scratch.size();
+        scratch.append(input.data() + start, pos - start);
+        while (pos < input.size()) {
+            char c = input[pos++];
+            if (c == '"') {
+                value = std::string_view(scratch.data() + scratchStart, scratch.size() - scratchStart);
+                return JsonParseStatus::Ok;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return fail("control character in string at offset " + std::to_string(pos - 1));
+            }
+            if (c != '\\') {
+                scratch += c;
+                continue;
+            }
+            if (pos == input.size()) {
+                break;
+            }
+
+            char escaped = input[pos++];
+            switch (escaped) {
+            case '"': scratch += '"'; break;
+            case '\\': scratch += '\\'; break;
+            case '/': scratch += '/'; break;
+            case 'b': scratch += '\b'; break;
+            case 'f': scratch += '\f'; break;
+            case 'n': scratch += '\n'; break;
+            case 'r': scratch += '\r'; break;
+            case 't': scratch += '\t'; break;
+            case 'u': {
+                unsigned codePoint = 0;
+                JsonParseStatus hex = readHex4(codePoint);
+                if (hex != JsonParseStatus::Ok) {
+                    return hex;
+                }
+                if (codePoint >= 0xd800 && codePoint < 0xdc00) {
+                    // High surrogate: must be followed by \uDC00-\uDFFF
+                    if (pos + 2 > input.size()) {
+                        return JsonParseStatus::Incomplete;
+                    }
+                    if (input[pos] != '\\' || input[pos + 1] != 'u') {
+                        return fail("unpaired surrogate at offset " + std::to_string(pos));
+                    }
+                    pos += 2;
+                    unsigned low = 0;
+                    hex = readHex4(low);
+                    if (hex != JsonParseStatus::Ok) {
+                        return hex;
+                    }
+                    if (low < 0xdc00 || low >= 0xe000) {
+                        return fail("unpaired surrogate at offset " + std::to_string(pos));
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                }
+                else if (codePoint >= 0xdc00 && codePoint < 0xe000) {
+                    return fail("unpaired surrogate at offset " + std::to_string(pos));
+                }
+                appendUtf8(scratch, codePoint);
+                break;
+            }
+            default:
+                return fail("invalid escape at offset " + std::to_string(pos - 1));
+            }
+        }
+        return JsonParseStatus::Incomplete;
+    }
+
+    JsonParseStatus Cursor::readHex4(unsigned& value) {
+        if (pos + 4 > input.size()) {
+            return JsonParseStatus::Incomplete;
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = input[pos++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<unsigned>(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<unsigned>(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<unsigned>(c - 'A' + 10);
+            }
+            else {
+                return fail("invalid \\u escape at offset " + std::to_string(pos - 1));
+            }
+        }
+        return JsonParseStatus::Ok;
+    }
+
+    // A number is only complete once a following character is seen
+    JsonParseStatus Cursor::readNumberToken(std::string_view& token) {
+        size_t start = pos;
+        while (pos < input.size() && isNumberChar(input[pos])) {
+            ++pos;
+        }
+        if (pos == input.size()) {
+            return JsonParseStatus::Incomplete;
+        }
+        token = input.substr(start, pos - start);
+        return JsonParseStatus::Ok;
+    }
+
+    JsonParseStatus Cursor::readInteger(const char* field, int64_t& value) {
+        char c = 0;
+        JsonParseStatus status = peek(c);
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+        if (c != '-' && (c < '0' || c > '9')) {
+            return fail(std::string("field '") + field + "' must be an integer");
+        }
+
+        std::string_view token;
+        status = readNumberToken(token);
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+        auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (result.ec == std::errc::result_out_of_range) {
+            return fail(std::string("field '") + field + "' is out of range");
+        }
+        if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+            return fail(std::string("field '") + field + "' must be an integer");
+        }
+        return JsonParseStatus::Ok;
+    }
+
+    JsonParseStatus Cursor::readDouble(const char* field, double& value) {
+        char c = 0;
+        JsonParseStatus status = peek(c);
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+        if (c != '-' && (c < '0' || c > '9')) {
+            return fail(std::string("field '") + field + "' must be a number");
+        }
+
+        std::string_view token;
+        status = readNumberToken(token);
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+        auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+            return fail(std::string("field '") + field + "' must be a number");
+        }
+        return JsonParseStatus::Ok;
+    }
+
+    JsonParseStatus Cursor::readBool(const char* field, bool& value) {
+        char c = 0;
+        JsonParseStatus status = peek(c);
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+
+        std::string_view literal = c == 't' ? "true" : "false";
+        if (c != 't' && c != 'f') {
+            return fail(std::string("field '") + field + "' must be true or false");
+        }
+        if (input.size() - pos < literal.size()) {
+            return input.substr(pos) == literal.substr(0, input.size() - pos)
+                ? JsonParseStatus::Incomplete
+                : fail(std::string("field '") + field + "' must be true or false");
+        }
+        if (input.substr(pos, literal.size()) != literal) {
+            return fail(std::string("field '") + field + "' must be true or false");
+        }
+        pos += literal.size();
+        value = c == 't';
+        return JsonParseStatus::Ok;
+    }
+
+    // Skips the value of an unknown key, including nested objects and arrays
+    JsonParseStatus Cursor::skipValue() {
+        std::string skipped;
+        int depth = 0;
+        do {
+            char c = 0;
+            JsonParseStatus status = peek(c);
+            if (status != JsonParseStatus::Ok) {
+                return status;
+            }
+
+            if (c == '"') {
+                std::string_view ignored;
+                skipped.clear();
+                status = readString(ignored, skipped);
+            }
+            else if (c == '{' || c == '[') {
+                ++depth;
+                ++pos;
+            }
+            else if (c == '}' || c == ']') {
+                if (depth == 0) {
+                    return fail("expected a value at offset " + std::to_string(pos));
+                }
+                --depth;
+                ++pos;
+            }
+            else if (c == ',' || c == ':') {
+                if (depth == 0) {
+                    return fail("expected a value at offset " + std::to_string(pos));
+                }
+                ++pos;
+            }
+            else {
+                size_t start = pos;
+                while (pos < input.size() && (isNumberChar(input[pos]) || (input[pos] >= 'a' && input[pos] <= 'z'))) {
+                    ++pos;
+                }
+                if (pos == input.size()) {
+                    return JsonParseStatus::Incomplete;
+                }
+                if (pos == start) {
+                    return fail("unexpected character at offset " + std::to_string(pos));
+                }
+            }
+            if (status != JsonParseStatus::Ok) {
+                return status;
+            }
+        } while (depth > 0);
+        return JsonParseStatus::Ok;
+    }
+
+    JsonParseStatus readField(Cursor& cursor, const char* field, std::string_view& value, std::string& scratch) {
+        char c = 0;
+        JsonParseStatus status = cursor.peek(c);
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+        if (c != '"') {
+            return cursor.fail(std::string("field '") + field + "' must be a string");
+        }
+        return cursor.readString(value, scratch);
+    }
+
+    JsonParseStatus readField(Cursor& cursor, const char* field, int& value, std::string&) {
+        int64_t wide = 0;
+        JsonParseStatus status = cursor.readInteger(field, wide);
+        if (status != JsonParseStatus::Ok) {
+            return status;
+        }
+        if (wide < INT_MIN || wide > INT_MAX) {
+            return cursor.fail(std::string("field '") + field + "' is out of range");
+        }
+        value = static_cast<int>(wide);
+        return JsonParseStatus::Ok;
+    }
+
+    JsonParseStatus readField(Cursor& cursor, const char* field, int64_t& value, std::string&) {
+        return cursor.readInteger(field, value);
+    }
+
+    JsonParseStatus readField(Cursor& cursor, const char* field, bool& value, std::string&) {
+        return cursor.readBool(field, value);
+    }
+
+    JsonParseStatus readField(Cursor& cursor, const char* field, double& value, std::string&) {
+        return cursor.readDouble(field, value);
+    }
+}
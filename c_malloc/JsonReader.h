@@ -0,0 +1,148 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include "TableSchema.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+// Schema-driven parser for flat JSON objects such as {"title": "...", "year": 2020}.
+// Values are read straight into the row: text fields become views of the input, or of
+// `scratch` when they contain escapes, so nothing is copied for plain strings and the
+// views stay valid while input and scratch are alive. Every schema column is required,
+// unknown keys are skipped. Running out of input reports Incomplete instead of an
+// error, so callers can feed an object that arrives in pieces.
+enum class JsonParseStatus {
+    Ok,
+    Incomplete,
+    Error
+};
+
+struct JsonParseResult {
+    JsonParseStatus status;
+    size_t consumed;        // Bytes up to and including the closing brace when Ok
+    std::string error;      // Set when status is Error
+};
+
+namespace json_reader {
+    class Cursor {
+    public:
+        explicit Cursor(std::string_view input) : input(input), pos(0) {}
+
+        size_t offset() const { return pos; }
+        const std::string& error() const { return message; }
+
+        // Skip whitespace and look at the next character without consuming it
+        JsonParseStatus peek(char& c);
+        JsonParseStatus expect(char c);
+        JsonParseStatus readString(std::string_view& value, std::string& scratch);
+        JsonParseStatus readInteger(const char* field, int64_t& value);
+        JsonParseStatus readDouble(const char* field, double& value);
+        JsonParseStatus readBool(const char* field, bool& value);
+        JsonParseStatus skipValue();
+        JsonParseStatus fail(std::string text);
+
+    private:
+        JsonParseStatus readNumberToken(std::string_view& token);
+        JsonParseStatus readHex4(unsigned& value);
+
+        std::string_view input;
+        size_t pos;
+        std::string message;
+    };
+
+    JsonParseStatus readField(Cursor& cursor, const char* field, std::string_view& value, std::string& scratch);
+    JsonParseStatus readField(Cursor& cursor, const char* field, int& value, std::string& scratch);
+    JsonParseStatus readField(Cursor& cursor, const char* field, int64_t& value, std::string& scratch);
+    JsonParseStatus readField(Cursor& cursor, const char* field, bool& value, std::string& scratch);
+    JsonParseStatus readField(Cursor& cursor, const char* field, double& value, std::string& scratch);
+}
+
+template <typename Row>
+class JsonRowReader {
+    using Schema = TableSchema<Row>;
+    static_assert(Table<Row>::columnCount <= 64, "column presence is tracked in a 64-bit mask");
+
+public:
+    // Parse one object at the start of `input` (leading whitespace allowed) into `row`.
+    // The key column is not read; set it separately when needed.
+    static JsonParseResult parse(std::string_view input, Row& row, std::string& scratch) {
+        json_reader::Cursor cursor(input);
+
+        // Unescaped text is never longer than its source, so with this much room the
+        // views handed out into scratch are never invalidated by a reallocation
+        scratch.clear();
+        if (scratch.capacity() < input.size()) {
+            scratch.reserve(input.size());
+        }
+
+        uint64_t seen = 0;
+        JsonParseStatus status = parseMembers(cursor, row, scratch, seen);
+        if (status == JsonParseStatus::Ok) {
+            status = checkRequired(cursor, seen);
+        }
+        return { status, cursor.offset(), status == JsonParseStatus::Error ? cursor.error() : std::string() };
+    }
+
+private:
+    static JsonParseStatus parseMembers(json_reader::Cursor& cursor, Row& row, std::string& scratch, uint64_t& seen) {
+        JsonParseStatus status = cursor.expect('{');
+        char next = 0;
+        if (status == JsonParseStatus::Ok) {
+            status = cursor.peek(next);
+        }
+        if (status == JsonParseStatus::Ok && next == '}') {
+            return cursor.expect('}');
+        }
+
+        while (status == JsonParseStatus::Ok) {
+            std::string_view key;
+            status = cursor.readString(key, scratch);
+            if (status == JsonParseStatus::Ok) {
+                status = cursor.expect(':');
+            }
+            if (status == JsonParseStatus::Ok) {
+                status = readMember(cursor, key, row, scratch, seen);
+            }
+            if (status == JsonParseStatus::Ok) {
+                status = cursor.peek(next);
+            }
+            if (status != JsonParseStatus::Ok) {
+                break;
+            }
+            if (next == '}') {
+                return cursor.expect('}');
+            }
+            if (next != ',') {
+                return cursor.fail("expected ',' or '}' at offset " + std::to_string(cursor.offset()));
+            }
+            status = cursor.expect(',');
+        }
+        return status;
+    }
+
+    static JsonParseStatus readMember(json_reader::Cursor& cursor, std::string_view key, Row& row, std::string& scratch, uint64_t& seen) {
+        JsonParseStatus status = JsonParseStatus::Ok;
+        bool matched = false;
+        size_t index = 0;
+        std::apply([&](const auto&... columns) {
+            ((!matched && key == columns.name
+                ? (matched = true, seen |= uint64_t(1) << index,
+                    status = json_reader::readField(cursor, columns.name, row.*(columns.member), scratch))
+                : status, ++index), ...);
+        }, Schema::columns);
+        return matched ? status : cursor.skipValue();
+    }
+
+    static JsonParseStatus checkRequired(json_reader::Cursor& cursor, uint64_t seen) {
+        const char* missing = nullptr;
+        size_t index = 0;
+        std::apply([&](const auto&... columns) {
+            ((missing = (!missing && !(seen & (uint64_t(1) << index))) ? columns.name : missing, ++index), ...);
+        }, Schema::columns);
+        return missing ? cursor.fail(std::string("missing field '") + missing + "'") : JsonParseStatus::Ok;
+    }
+};
+
+#endif // JSON_READER_H
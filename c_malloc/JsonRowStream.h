@@ -0,0 +1,171 @@
+#ifndef JSON_ROW_STREAM_H
+#define JSON_ROW_STREAM_H
+
+#include "JsonReader.h"
+#include <string>
+#include <string_view>
+
+// Incremental reader for a stream of schema rows, either one JSON array of objects or
+// NDJSON (objects separated by whitespace, usually newlines); the first character
+// decides. Bytes are fed as they arrive and every complete object is handed out at
+// once, so the body never has to be held in memory as a whole.
+//
+// An object that is well-formed JSON but not a valid row (missing field, wrong type)
+// is reported through onError and skipped. Malformed JSON ends the stream, except in
+// NDJSON where reading resumes at the next line.
+template <typename Row>
+class JsonRowStream {
+public:
+    static const size_t maxItemBytes = 1024 * 1024;
+
+    JsonRowStream() : consumed(0), mode(Mode::Unknown), state(State::ExpectItem), index(0) {}
+
+    // onRow(index, row): the row's text views are only valid during the call.
+    // onError(index, message). Returns false once the stream is malformed.
+    template <typename OnRow, typename OnError>
+    bool feed(std::string_view data, OnRow&& onRow, OnError&& onError) {
+        if (state == State::Failed) {
+            return false;
+        }
+
+        buffer.erase(0, consumed);
+        consumed = 0;
+        buffer.append(data.data(), data.size());
+
+        while (true) {
+            size_t next = buffer.find_first_not_of(" \t\r\n", consumed);
+            if (next == std::string::npos) {
+                consumed = buffer.size();
+                return true;
+            }
+            consumed = next;
+            char c = buffer[consumed];
+
+            if (mode == Mode::Unknown) {
+                if (c == '[') {
+                    mode = Mode::Array;
+                    ++consumed;
+                    state = State::ExpectItemOrEnd;
+                    continue;
+                }
+                if (c != '{') {
+                    return fail("expected a JSON array or NDJSON objects");
+                }
+                mode = Mode::Lines;
+            }
+
+            if (state == State::Finished) {
+                return fail("unexpected data after the end of the array");
+            }
+            if (mode == Mode::Array && state == State::ExpectSeparator) {
+                if (c == ',') {
+                    ++consumed;
+                    state = State::ExpectItem;
+                    continue;
+                }
+                if (c != ']') {
+                    return fail("expected ',' or ']' after item " + std::to_string(index - 1));
+                }
+                ++consumed;
+                state = State::Finished;
+                continue;
+            }
+            if (mode == Mode::Array && state == State::ExpectItemOrEnd && c == ']') {
+                ++consumed;
+                state = State::Finished;
+                continue;
+            }
+
+            bool complete = true;
+            if (!readItem(onRow, onError, complete)) {
+                return false;
+            }
+            if (!complete) {
+                return true;
+            }
+        }
+    }
+
+    // Call after the last feed; false if the input stopped in the middle of something.
+    bool finish() {
+        if (state == State::Failed) {
+            return false;
+        }
+        if (buffer.find_first_not_of(" \t\r\n", consumed) != std::string::npos) {
+            return fail("unexpected end of input in item " + std::to_string(index));
+        }
+        if (mode == Mode::Array && state != State::Finished) {
+            return fail("unexpected end of input: the array is not closed");
+        }
+        return true;
+    }
+
+    const std::string& error() const { return message; }
+    size_t itemCount() const { return index; }
+
+private:
+    enum class Mode { Unknown, Array, Lines };
+    enum class State { ExpectItem, ExpectItemOrEnd, ExpectSeparator, Finished, Failed };
+
+    template <typename OnRow, typename OnError>
+    bool readItem(OnRow& onRow, OnError& onError, bool& complete) {
+        std::string_view input(buffer.data() + consumed, buffer.size() - consumed);
+        Row row{};
+        JsonParseResult parsed = JsonRowReader<Row>::parse(input, row, scratch);
+
+        if (parsed.status == JsonParseStatus::Ok) {
+            onRow(index++, row);
+            consumed += parsed.consumed;
+            state = State::ExpectSeparator;
+            return true;
+        }
+        if (parsed.status == JsonParseStatus::Incomplete) {
+            complete = false;
+            return input.size() <= maxItemBytes || fail("item " + std::to_string(index) + " is too large");
+        }
+
+        // Not a valid row: step over the whole object if it is at least well-formed JSON.
+        // NDJSON items never span lines, so there the skip must stay within the line.
+        json_reader::Cursor cursor(input);
+        JsonParseStatus skipped = cursor.skipValue();
+        size_t lineEnd = mode == Mode::Lines ? input.find('\n') : std::string_view::npos;
+        if (skipped == JsonParseStatus::Ok && (lineEnd == std::string_view::npos || cursor.offset() <= lineEnd)) {
+            onError(index++, parsed.error);
+            consumed += cursor.offset();
+            state = State::ExpectSeparator;
+            return true;
+        }
+
+        if (mode == Mode::Array) {
+            if (skipped == JsonParseStatus::Incomplete) {
+                complete = false;
+                return input.size() <= maxItemBytes || fail("item " + std::to_string(index) + " is too large");
+            }
+            return fail("item " + std::to_string(index) + ": " + parsed.error);
+        }
+        if (lineEnd == std::string_view::npos) {
+            complete = false;
+            return input.size() <= maxItemBytes || fail("item " + std::to_string(index) + " is too large");
+        }
+        onError(index++, parsed.error);
+        consumed += lineEnd + 1;
+        state = State::ExpectItem;
+        return true;
+    }
+
+    bool fail(std::string text) {
+        message = std::move(text);
+        state = State::Failed;
+        return false;
+    }
+
+    std::string buffer;
+    size_t consumed;        // Bytes of buffer already handed out
+    std::string scratch;
+    std::string message;
+    Mode mode;
+    State state;
+    size_t index;
+};
+
+#endif // JSON_ROW_STREAM_H
@@ -0,0 +1,66 @@
+#include "JsonWriter.h"
+#include <charconv>
+#include <cmath>
+
+namespace json_writer {
+    // Appends runs of plain characters in one go and escapes only what JSON requires.
+    // Bytes >= 0x80 are passed through, so valid UTF-8 stays valid.
+    void appendString(std::string& out, std::string_view text) {
+        static const char hexDigits[] = "0123456789abcdef";
+
+        out += '"';
+        size_t runStart = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+
+            out.append(text.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += hexDigits[c >> 4];
+                out += hexDigits[c & 0x0f];
+                break;
+            }
+        }
+        out.append(text.data() + runStart, text.size() - runStart);
+        out += '"';
+    }
+
+    void appendValue(std::string& out, int value) {
+        char digits[16];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    void appendValue(std::string& out, int64_t value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    void appendValue(std::string& out, bool value) {
+        out += value ? "true" : "false";
+    }
+
+    // JSON has no NaN or infinity; they are written as null
+    void appendValue(std::string& out, double value) {
+        if (!std::isfinite(value)) {
+            out += "null";
+            return;
+        }
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+}
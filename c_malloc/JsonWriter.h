@@ -0,0 +1,59 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include "TableSchema.h"
+#include <sqlite3.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+// Serializes schema rows as JSON objects by appending to a caller-owned buffer.
+// Keys come from TableSchema<Row> in column order, text is escaped on the fly and
+// numbers are formatted with std::to_chars, so a row costs no allocations once the
+// buffer has grown to size. Reuse one buffer across rows and requests.
+namespace json_writer {
+    void appendString(std::string& out, std::string_view text);
+    void appendValue(std::string& out, int value);
+    void appendValue(std::string& out, int64_t value);
+    void appendValue(std::string& out, bool value);
+    void appendValue(std::string& out, double value);
+
+    inline void appendValue(std::string& out, std::string_view value) {
+        appendString(out, value);
+    }
+
+    inline void appendKey(std::string& out, const char* name, bool first) {
+        out += first ? "{\"" : ",\"";
+        out += name;
+        out += "\":";
+    }
+}
+
+template <typename Row>
+class JsonRowWriter {
+    using Schema = TableSchema<Row>;
+
+public:
+    static void append(std::string& out, const Row& row) {
+        bool first = true;
+        if constexpr (Table<Row>::hasKey) {
+            json_writer::appendKey(out, Schema::key.name, first);
+            json_writer::appendValue(out, row.*(Schema::key.member));
+            first = false;
+        }
+        std::apply([&](const auto&... columns) {
+            ((json_writer::appendKey(out, columns.name, first), first = false,
+                json_writer::appendValue(out, row.*(columns.member))), ...);
+        }, Schema::columns);
+        out += '}';
+    }
+
+    // Current row of a statement laid out like Table<Row>::selectSql(). Text is read
+    // through views of SQLite's column buffers and copied only into `out`.
+    static void append(std::string& out, sqlite3_stmt* stmt, int first = 0) {
+        append(out, Table<Row>::extract(stmt, first));
+    }
+};
+
+#endif // JSON_WRITER_H
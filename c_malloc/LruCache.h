@@ -0,0 +1,99 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+// Bounded, thread-safe least-recently-used cache. Values are shared immutable
+// snapshots so readers can keep using an entry after it has been evicted.
+// A capacity of 0 disables the cache.
+template <typename Key, typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity = 0) : maxEntries(capacity), generation(0) {}
+
+    void setCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxEntries = capacity;
+        evict();
+    }
+
+    bool enabled() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return maxEntries > 0;
+    }
+
+    // Bumped by every erase/clear. Take it before loading a value and pass it to
+    // put() so a load that raced with an invalidation is not cached.
+    uint64_t version() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return generation;
+    }
+
+    std::shared_ptr<const Value> get(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    void put(const Key& key, std::shared_ptr<const Value> value, uint64_t loadedAtVersion) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (maxEntries == 0 || loadedAtVersion != generation) {
+            return;
+        }
+
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = std::move(value);
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+
+        entries.emplace_front(key, std::move(value));
+        index[key] = entries.begin();
+        evict();
+    }
+
+    void erase(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.erase(it->second);
+            index.erase(it);
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+        entries.clear();
+        index.clear();
+    }
+
+private:
+    using Entry = std::pair<Key, std::shared_ptr<const Value>>;
+
+    void evict() {
+        while (entries.size() > maxEntries) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    std::list<Entry> entries;   // Most recently used first
+    std::unordered_map<Key, typename std::list<Entry>::iterator> index;
+    size_t maxEntries;
+    uint64_t generation;
+    mutable std::mutex mutex;
+};
+
+#endif // LRU_CACHE_H
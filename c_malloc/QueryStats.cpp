@@ -0,0 +1,172 @@
+#include "QueryStats.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // A statement run in progress: when it started and how many rows it returned so far.
+    // A connection is only used by one thread at a time, so tracking per thread needs no locking.
+    struct PendingRun {
+        std::chrono::steady_clock::time_point start;
+        uint64_t rows;
+    };
+
+    thread_local std::unordered_map<sqlite3_stmt*, PendingRun> pendingRuns;
+
+    size_t bucketFor(uint64_t ns, size_t bucketCount) {
+        uint64_t micros = ns / 1000;
+        size_t bucket = 0;
+        while (micros > 1 && bucket + 1 < bucketCount) {
+            micros >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    double toMillis(uint64_t ns) {
+        return static_cast<double>(ns) / 1e6;
+    }
+}
+
+QueryStats::QueryStats() : slowThresholdNs(UINT64_MAX) {}
+
+void QueryStats::setSlowQueryThreshold(std::chrono::microseconds threshold) {
+    std::lock_guard<std::mutex> lock(mutex);
+    slowThresholdNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(threshold).count());
+}
+
+void QueryStats::attach(sqlite3* db) {
+    sqlite3_trace_v2(db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, &QueryStats::traceCallback, this);
+}
+
+void QueryStats::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    statements.clear();
+    slowQueries.clear();
+}
+
+int QueryStats::traceCallback(unsigned type, void* context, void* p, void* x) {
+    auto* stmt = static_cast<sqlite3_stmt*>(p);
+    if (type == SQLITE_TRACE_STMT) {
+        // Trigger sub-programs report "-- <trigger>" text; keep the outermost start time
+        const char* text = static_cast<const char*>(x);
+        if (!(text[0] == '-' && text[1] == '-')) {
+            pendingRuns[stmt] = PendingRun{ std::chrono::steady_clock::now(), 0 };
+        }
+    }
+    else if (type == SQLITE_TRACE_ROW) {
+        // Internal statements (e.g. schema loading) report rows without a start event
+        auto pending = pendingRuns.find(stmt);
+        if (pending != pendingRuns.end()) {
+            ++pending->second.rows;
+        }
+    }
+    else if (type == SQLITE_TRACE_PROFILE) {
+        // SQLite's own estimate only has the VFS clock's millisecond resolution
+        uint64_t ns = static_cast<uint64_t>(*static_cast<sqlite3_int64*>(x));
+        uint64_t rows = 0;
+        auto pending = pendingRuns.find(stmt);
+        if (pending != pendingRuns.end()) {
+            ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - pending->second.start).count());
+            rows = pending->second.rows;
+            pendingRuns.erase(pending);
+        }
+        static_cast<QueryStats*>(context)->recordProfile(stmt, ns, rows);
+    }
+    return 0;
+}
+
+void QueryStats::recordProfile(sqlite3_stmt* stmt, uint64_t ns, uint64_t rows) {
+    // Reset the counters so the next run of a cached statement starts from zero
+    uint64_t fullScanSteps = static_cast<uint64_t>(sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1));
+    uint64_t vmSteps = static_cast<uint64_t>(sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1));
+
+    const char* sqlText = sqlite3_sql(stmt);
+    std::string sql = sqlText ? sqlText : "";
+
+    std::lock_guard<std::mutex> lock(mutex);
+    StatementStats& stats = statements[sql];
+    ++stats.calls;
+    stats.totalNs += ns;
+    stats.maxNs = std::max(stats.maxNs, ns);
+    stats.rowsReturned += rows;
+    stats.fullScanSteps += fullScanSteps;
+    stats.vmSteps += vmSteps;
+    ++stats.histogram[bucketFor(ns, bucketCount)];
+
+    if (ns >= slowThresholdNs) {
+        char* expanded = sqlite3_expanded_sql(stmt);
+        std::string expandedSql = expanded ? expanded : sql;
+        sqlite3_free(expanded);
+
+        std::cerr << "Slow query (" << toMillis(ns) << " ms): " << expandedSql << std::endl;
+        slowQueries.push_back({ expandedSql, ns });
+        if (slowQueries.size() > slowQueryLimit) {
+            slowQueries.pop_front();
+        }
+    }
+}
+
+// Upper bound of the histogram bucket containing the requested fraction of calls
+uint64_t QueryStats::percentile(const StatementStats& stats, double fraction) {
+    uint64_t target = static_cast<uint64_t>(static_cast<double>(stats.calls) * fraction);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketCount; ++i) {
+        seen += stats.histogram[i];
+        if (seen > target || seen == stats.calls) {
+            return (uint64_t(2) << i) * 1000;
+        }
+    }
+    return stats.maxNs;
+}
+
+void QueryStats::report(std::ostream& out, sqlite3* db) const {
+    std::vector<std::pair<std::string, StatementStats>> sorted;
+    std::deque<SlowQuery> slow;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted.assign(statements.begin(), statements.end());
+        slow = slowQueries;
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second.totalNs > b.second.totalNs;
+    });
+
+    out << "==================== Query Statistics ====================\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& entry : sorted) {
+        const StatementStats& stats = entry.second;
+        out << "\n" << entry.first << "\n";
+        out << "    calls: " << stats.calls
+            << ", total: " << toMillis(stats.totalNs) << " ms"
+            << ", avg: " << toMillis(stats.totalNs / stats.calls) << " ms"
+            << ", p50 <= " << toMillis(percentile(stats, 0.50)) << " ms"
+            << ", p95 <= " << toMillis(percentile(stats, 0.95)) << " ms"
+            << ", max: " << toMillis(stats.maxNs) << " ms\n";
+        out << "    rows returned: " << stats.rowsReturned
+            << ", full scan steps: " << stats.fullScanSteps
+            << ", VM steps: " << stats.vmSteps << "\n";
+    }
+
+    out << "\n==================== Slow Queries ====================\n";
+    if (slow.empty()) {
+        out << "None\n";
+    }
+    for (const auto& query : slow) {
+        out << "\n(" << toMillis(query.ns) << " ms) " << query.sql << "\n";
+
+        std::string explain = "EXPLAIN QUERY PLAN " + query.sql;
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            out << "    (no plan: " << sqlite3_errmsg(db) << ")\n";
+            continue;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            out << "    " << reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)) << "\n";
+        }
+        sqlite3_finalize(stmt);
+    }
+}
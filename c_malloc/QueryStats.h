@@ -0,0 +1,60 @@
+#ifndef QUERY_STATS_H
+#define QUERY_STATS_H
+
+#include <sqlite3.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+// Per-statement execution statistics collected through sqlite3_trace_v2.
+// Every finished statement contributes its latency (log2 microsecond histogram),
+// rows returned, full-scan steps and VM steps from sqlite3_stmt_status. Statements
+// slower than the threshold are logged to std::cerr and kept for the report, which
+// prints their EXPLAIN QUERY PLAN.
+class QueryStats {
+public:
+    QueryStats();
+
+    void setSlowQueryThreshold(std::chrono::microseconds threshold);
+    // Start tracing a connection; must not race with other use of that connection.
+    void attach(sqlite3* db);
+    void reset();
+
+    // Plans for slow queries are computed on `db` while reporting.
+    void report(std::ostream& out, sqlite3* db) const;
+
+private:
+    static const size_t bucketCount = 24;       // up to ~8 s in microsecond buckets
+    static const size_t slowQueryLimit = 100;
+
+    struct StatementStats {
+        uint64_t calls = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+        uint64_t rowsReturned = 0;
+        uint64_t fullScanSteps = 0;
+        uint64_t vmSteps = 0;
+        std::array<uint64_t, bucketCount> histogram{};
+    };
+
+    struct SlowQuery {
+        std::string sql;
+        uint64_t ns;
+    };
+
+    static int traceCallback(unsigned type, void* context, void* p, void* x);
+    void recordProfile(sqlite3_stmt* stmt, uint64_t ns, uint64_t rows);
+    static uint64_t percentile(const StatementStats& stats, double fraction);
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, StatementStats> statements;   // Keyed by SQL text
+    std::deque<SlowQuery> slowQueries;
+    uint64_t slowThresholdNs;
+};
+
+#endif // QUERY_STATS_H
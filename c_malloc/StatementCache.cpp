@@ -0,0 +1,35 @@
+#include "StatementCache.h"
+
+StatementCache::StatementCache(sqlite3* db) : db(db) {}
+
+StatementCache::~StatementCache() {
+    clear();
+}
+
+ScopedStatement StatementCache::prepare(const std::string& sql) {
+    auto it = statements.find(sql);
+    if (it != statements.end() && !sqlite3_stmt_busy(it->second)) {
+        return ScopedStatement(it->second);
+    }
+
+    bool nested = it != statements.end();
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db, sql.c_str(), -1, nested ? 0 : SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return ScopedStatement(nullptr);
+    }
+    if (nested) {
+        return ScopedStatement(stmt, true);
+    }
+
+    statements.emplace(sql, stmt);
+    return ScopedStatement(stmt);
+}
+
+// Must run before the connection is closed, or sqlite3_close reports SQLITE_BUSY.
+void StatementCache::clear() {
+    for (auto& entry : statements) {
+        sqlite3_finalize(entry.second);
+    }
+    statements.clear();
+}
@@ -0,0 +1,59 @@
+#ifndef STATEMENT_CACHE_H
+#define STATEMENT_CACHE_H
+
+#include <sqlite3.h>
+#include <string>
+#include <unordered_map>
+
+// Borrowed cached statement. Resets it and clears its bindings when it goes out of
+// scope, which also ends any read transaction the statement had open. An owned
+// statement is not in the cache and is finalized instead.
+class ScopedStatement {
+public:
+    explicit ScopedStatement(sqlite3_stmt* stmt, bool owned = false) : stmt(stmt), owned(owned) {}
+    ScopedStatement(ScopedStatement&& other) noexcept : stmt(other.stmt), owned(other.owned) { other.stmt = nullptr; }
+    ScopedStatement(const ScopedStatement&) = delete;
+    ScopedStatement& operator=(const ScopedStatement&) = delete;
+    ScopedStatement& operator=(ScopedStatement&&) = delete;
+
+    ~ScopedStatement() {
+        if (owned) {
+            sqlite3_finalize(stmt);
+        }
+        else if (stmt) {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+    }
+
+    sqlite3_stmt* get() const { return stmt; }
+    explicit operator bool() const { return stmt != nullptr; }
+
+private:
+    sqlite3_stmt* stmt;
+    bool owned;
+};
+
+// Prepared statements of one connection, keyed by their SQL text. Each statement is
+// compiled once (as SQLITE_PREPARE_PERSISTENT) and reused for the connection's lifetime.
+// Not thread-safe: it is only touched by whoever holds the connection.
+class StatementCache {
+public:
+    explicit StatementCache(sqlite3* db);
+    ~StatementCache();
+
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    // Empty on prepare failure; sqlite3_errmsg on the connection has the reason.
+    // While the cached statement is still being stepped (e.g. a visitor running the
+    // same query again on a re-entrant lease) a one-off statement is returned instead.
+    ScopedStatement prepare(const std::string& sql);
+    void clear();
+
+private:
+    sqlite3* db;
+    std::unordered_map<std::string, sqlite3_stmt*> statements;
+};
+
+#endif // STATEMENT_CACHE_H
@@ -0,0 +1,189 @@
+#include "StudentSnapshot.h"
+#include <algorithm>
+#include <iostream>
+
+StudentSnapshot::Segment::Segment() : nameOffsets(1, 0) {}
+
+StudentSnapshot::StudentSnapshot() {
+    clear();
+}
+
+// New rows go into a private copy of the partly filled last segment and then into fresh
+// segments. Shared segments are never written, and the dictionary is only copied when a
+// new department shows up.
+bool StudentSnapshot::refresh(sqlite3* db) {
+    const char* sql = "SELECT id, first_name, last_name, department FROM students WHERE id > ? ORDER BY id;";
+    sqlite3_stmt* stmt;
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_int(stmt, 1, lastId());
+
+    std::vector<std::shared_ptr<const Segment>> nextSegments = segments;
+    std::shared_ptr<DepartmentDictionary> nextDictionary;
+    std::shared_ptr<Segment> tail;
+    size_t added = 0;
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (!tail) {
+            if (!nextSegments.empty() && nextSegments.back()->ids.size() < segmentRows) {
+                tail = std::make_shared<Segment>(*nextSegments.back());
+                nextSegments.pop_back();
+            }
+            else {
+                tail = std::make_shared<Segment>();
+            }
+        }
+
+        tail->ids.push_back(sqlite3_column_int(stmt, 0));
+
+        tail->nameArena.append(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+            static_cast<size_t>(sqlite3_column_bytes(stmt, 1)));
+        tail->nameOffsets.push_back(tail->nameArena.size());
+        tail->nameArena.append(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)),
+            static_cast<size_t>(sqlite3_column_bytes(stmt, 2)));
+        tail->nameOffsets.push_back(tail->nameArena.size());
+
+        std::string department(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)),
+            static_cast<size_t>(sqlite3_column_bytes(stmt, 3)));
+        const DepartmentDictionary& known = nextDictionary ? *nextDictionary : *dictionary;
+        auto it = known.index.find(department);
+        uint32_t code;
+        if (it != known.index.end()) {
+            code = it->second;
+        }
+        else {
+            if (!nextDictionary) {
+                nextDictionary = std::make_shared<DepartmentDictionary>(*dictionary);
+            }
+            code = static_cast<uint32_t>(nextDictionary->names.size());
+            nextDictionary->index.emplace(department, code);
+            nextDictionary->names.push_back(std::move(department));
+        }
+        tail->departmentCodes.push_back(code);
+
+        ++added;
+        if (tail->ids.size() == segmentRows) {
+            nextSegments.push_back(std::move(tail));
+        }
+    }
+
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to refresh student snapshot: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    if (tail) {
+        nextSegments.push_back(std::move(tail));
+    }
+    segments = std::move(nextSegments);
+    if (nextDictionary) {
+        dictionary = std::move(nextDictionary);
+    }
+    rowCount += added;
+    return true;
+}
+
+void StudentSnapshot::clear() {
+    segments.clear();
+    dictionary = std::make_shared<DepartmentDictionary>();
+    rowCount = 0;
+}
+
+size_t StudentSnapshot::size() const {
+    return rowCount;
+}
+
+int StudentSnapshot::lastId() const {
+    return segments.empty() ? 0 : segments.back()->ids.back();
+}
+
+size_t StudentSnapshot::departmentCount() const {
+    return dictionary->names.size();
+}
+
+uint32_t StudentSnapshot::departmentCode(std::string_view department) const {
+    auto it = dictionary->index.find(std::string(department));
+    return it == dictionary->index.end() ? noDepartment : it->second;
+}
+
+std::string_view StudentSnapshot::departmentName(uint32_t code) const {
+    return dictionary->names[code];
+}
+
+const StudentSnapshot::Segment& StudentSnapshot::segmentOf(size_t row) const {
+    return *segments[row / segmentRows];
+}
+
+int StudentSnapshot::idAt(size_t row) const {
+    return segmentOf(row).ids[row % segmentRows];
+}
+
+std::string_view StudentSnapshot::firstNameAt(size_t row) const {
+    const Segment& segment = segmentOf(row);
+    size_t local = row % segmentRows;
+    return std::string_view(segment.nameArena).substr(segment.nameOffsets[2 * local],
+        segment.nameOffsets[2 * local + 1] - segment.nameOffsets[2 * local]);
+}
+
+std::string_view StudentSnapshot::lastNameAt(size_t row) const {
+    const Segment& segment = segmentOf(row);
+    size_t local = row % segmentRows;
+    return std::string_view(segment.nameArena).substr(segment.nameOffsets[2 * local + 1],
+        segment.nameOffsets[2 * local + 2] - segment.nameOffsets[2 * local + 1]);
+}
+
+std::string_view StudentSnapshot::departmentAt(size_t row) const {
+    return dictionary->names[segmentOf(row).departmentCodes[row % segmentRows]];
+}
+
+std::vector<uint32_t> StudentSnapshot::filterByDepartment(std::string_view department) const {
+    std::vector<uint32_t> rows;
+    uint32_t code = departmentCode(department);
+    if (code == noDepartment) {
+        return rows;
+    }
+
+    // Branch-free selection: always write the candidate, only advance on a match
+    rows.resize(rowCount);
+    size_t matches = 0;
+    uint32_t first = 0;
+    for (const auto& segment : segments) {
+        const uint32_t* codes = segment->departmentCodes.data();
+        size_t count = segment->departmentCodes.size();
+        for (size_t i = 0; i < count; ++i) {
+            rows[matches] = first + static_cast<uint32_t>(i);
+            matches += codes[i] == code;
+        }
+        first += static_cast<uint32_t>(count);
+    }
+    rows.resize(matches);
+    return rows;
+}
+
+size_t StudentSnapshot::countInDepartment(std::string_view department) const {
+    uint32_t code = departmentCode(department);
+    if (code == noDepartment) {
+        return 0;
+    }
+    size_t count = 0;
+    for (const auto& segment : segments) {
+        count += static_cast<size_t>(std::count(segment->departmentCodes.begin(), segment->departmentCodes.end(), code));
+    }
+    return count;
+}
+
+std::vector<size_t> StudentSnapshot::countByDepartment() const {
+    std::vector<size_t> counts(dictionary->names.size(), 0);
+    for (const auto& segment : segments) {
+        for (uint32_t code : segment->departmentCodes) {
+            ++counts[code];
+        }
+    }
+    return counts;
+}
@@ -0,0 +1,79 @@
+#ifndef STUDENT_SNAPSHOT_H
+#define STUDENT_SNAPSHOT_H
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Column-oriented in-memory copy of the students table for analytics scans.
+// Ids and department codes live in contiguous arrays, departments are dictionary
+// encoded and names are packed into a single arena, so filters and group-by counts
+// are tight loops over flat memory instead of B-tree page walks.
+//
+// Rows are stored in segments of segmentRows rows that never change once filled, and
+// the segments and department dictionary are shared between copies. Copying a snapshot
+// and refreshing the copy therefore costs the new rows plus at most one partly filled
+// segment, and never disturbs the original.
+//
+// refresh() only appends rows whose id is newer than the last one loaded; rows
+// changed in place need a clear() followed by a refresh().
+class StudentSnapshot {
+public:
+    static const uint32_t noDepartment = UINT32_MAX;
+    static const size_t segmentRows = 1 << 16;
+
+    StudentSnapshot();
+
+    // Leaves the snapshot unchanged when the query fails
+    bool refresh(sqlite3* db);
+    void clear();
+
+    size_t size() const;
+    int lastId() const;
+
+    size_t departmentCount() const;
+    uint32_t departmentCode(std::string_view department) const;   // noDepartment if unknown
+    std::string_view departmentName(uint32_t code) const;
+
+    int idAt(size_t row) const;
+    std::string_view firstNameAt(size_t row) const;
+    std::string_view lastNameAt(size_t row) const;
+    std::string_view departmentAt(size_t row) const;
+
+    // Row positions of all students in a department
+    std::vector<uint32_t> filterByDepartment(std::string_view department) const;
+    size_t countInDepartment(std::string_view department) const;
+    // Student count per department, indexed by department code
+    std::vector<size_t> countByDepartment() const;
+
+private:
+    struct Segment {
+        Segment();
+
+        std::vector<int> ids;
+        std::vector<uint32_t> departmentCodes;
+
+        // Row r's first name is [nameOffsets[2r], nameOffsets[2r+1]) and its last name
+        // is [nameOffsets[2r+1], nameOffsets[2r+2]) within nameArena.
+        std::string nameArena;
+        std::vector<size_t> nameOffsets;
+    };
+
+    struct DepartmentDictionary {
+        std::vector<std::string> names;
+        std::unordered_map<std::string, uint32_t> index;
+    };
+
+    // Every segment but the last holds exactly segmentRows rows
+    const Segment& segmentOf(size_t row) const;
+
+    std::vector<std::shared_ptr<const Segment>> segments;
+    std::shared_ptr<const DepartmentDictionary> dictionary;
+    size_t rowCount;
+};
+
+#endif // STUDENT_SNAPSHOT_H
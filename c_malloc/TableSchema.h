@@ -0,0 +1,269 @@
+#ifndef TABLE_SCHEMA_H
+#define TABLE_SCHEMA_H
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+// Compile-time table descriptions.
+//
+// Every row struct gets a TableSchema<Row> specialization that lists its columns as
+// (name, SQL definition, member pointer). Table<Row> derives the CREATE / INSERT /
+// SELECT / UPDATE text and the bind/extract code from that one list, so binding is
+// checked against the member types and adding a column is a one-line change.
+//
+// A specialization provides:
+//     static constexpr const char* name;          table name
+//     static constexpr auto key;                  autoKey(...) or NoKey{}
+//     static constexpr auto columns;              std::make_tuple(column(...), ...)
+//     static constexpr const char* constraints;   extra CREATE TABLE clauses, may be ""
+//     static constexpr const char* options;       e.g. "WITHOUT ROWID", may be ""
+
+template <typename Row, typename T>
+struct Column {
+    const char* name;
+    const char* definition;
+    T Row::* member;
+};
+
+template <typename Row, typename T>
+constexpr Column<Row, T> column(const char* name, const char* definition, T Row::* member) {
+    return { name, definition, member };
+}
+
+// INTEGER PRIMARY KEY AUTOINCREMENT column: assigned by SQLite, skipped on insert
+template <typename Row>
+struct AutoKey {
+    const char* name;
+    int Row::* member;
+};
+
+template <typename Row>
+constexpr AutoKey<Row> autoKey(const char* name, int Row::* member) {
+    return { name, member };
+}
+
+struct NoKey {};
+
+template <typename Row>
+struct TableSchema;
+
+namespace schema_detail {
+    inline int bindValue(sqlite3_stmt* stmt, int index, int value) {
+        return sqlite3_bind_int(stmt, index, value);
+    }
+
+    inline int bindValue(sqlite3_stmt* stmt, int index, int64_t value) {
+        return sqlite3_bind_int64(stmt, index, value);
+    }
+
+    inline int bindValue(sqlite3_stmt* stmt, int index, bool value) {
+        return sqlite3_bind_int(stmt, index, value ? 1 : 0);
+    }
+
+    inline int bindValue(sqlite3_stmt* stmt, int index, double value) {
+        return sqlite3_bind_double(stmt, index, value);
+    }
+
+    // Text is bound without copying, so the viewed characters must outlive the step.
+    // A default-constructed view has no data pointer and would bind NULL, hence "".
+    inline int bindValue(sqlite3_stmt* stmt, int index, std::string_view value) {
+        return sqlite3_bind_text(stmt, index, value.data() ? value.data() : "",
+            static_cast<int>(value.size()), SQLITE_STATIC);
+    }
+
+    inline void extractValue(sqlite3_stmt* stmt, int index, int& value) {
+        value = sqlite3_column_int(stmt, index);
+    }
+
+    inline void extractValue(sqlite3_stmt* stmt, int index, int64_t& value) {
+        value = sqlite3_column_int64(stmt, index);
+    }
+
+    inline void extractValue(sqlite3_stmt* stmt, int index, bool& value) {
+        value = sqlite3_column_int(stmt, index) != 0;
+    }
+
+    inline void extractValue(sqlite3_stmt* stmt, int index, double& value) {
+        value = sqlite3_column_double(stmt, index);
+    }
+
+    // Views SQLite's column buffer; valid until the statement is stepped or reset
+    inline void extractValue(sqlite3_stmt* stmt, int index, std::string_view& value) {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, index));
+        value = text ? std::string_view(text, static_cast<size_t>(sqlite3_column_bytes(stmt, index))) : std::string_view();
+    }
+}
+
+template <typename Row>
+class Table {
+    using Schema = TableSchema<Row>;
+
+public:
+    static constexpr bool hasKey = !std::is_same<std::decay_t<decltype(Schema::key)>, NoKey>::value;
+    static constexpr size_t columnCount = std::tuple_size<std::decay_t<decltype(Schema::columns)>>::value;
+
+    // The SQL text is assembled once per table on first use and then reused.
+    static const std::string& createSql() {
+        static const std::string sql = buildCreate();
+        return sql;
+    }
+
+    static const std::string& insertSql() {
+        static const std::string sql = buildInsert("INSERT");
+        return sql;
+    }
+
+    static const std::string& insertOrIgnoreSql() {
+        static const std::string sql = buildInsert("INSERT OR IGNORE");
+        return sql;
+    }
+
+    // "SELECT <key>, <columns> FROM <table>" without a terminator, ready for WHERE/ORDER BY
+    static const std::string& selectSql() {
+        static const std::string sql = "SELECT " + columnList(true) + " FROM " + Schema::name;
+        return sql;
+    }
+
+    // Insert that updates the existing row when `conflictColumn` (which must carry a
+    // unique index) already holds the value. Rows whose values are all unchanged are
+    // left untouched, so re-importing the same data writes nothing.
+    static std::string upsertSql(std::string_view conflictColumn) {
+        std::string sql = buildInsert("INSERT");
+        sql.pop_back();
+        sql += " ON CONFLICT (" + std::string(conflictColumn) + ") DO UPDATE SET ";
+
+        std::string changed;
+        std::apply([&](const auto&... columns) {
+            (appendUpsertColumn(sql, changed, conflictColumn, columns.name), ...);
+        }, Schema::columns);
+        sql += " WHERE " + changed + ";";
+        return sql;
+    }
+
+    static bool hasColumn(std::string_view name) {
+        bool found = false;
+        std::apply([&](const auto&... columns) {
+            ((found = found || name == columns.name), ...);
+        }, Schema::columns);
+        return found;
+    }
+
+    static const std::string& updateSql() {
+        static_assert(hasKey, "UPDATE needs a key column");
+        static const std::string sql = buildUpdate();
+        return sql;
+    }
+
+    // Comma separated column names, optionally starting with the key and optionally
+    // qualified ("students.id, students.first_name, ...") for use in joins
+    static std::string columnList(bool withKey, std::string_view qualifier = std::string_view()) {
+        std::string prefix = qualifier.empty() ? std::string() : std::string(qualifier) + ".";
+        std::string list;
+        if constexpr (hasKey) {
+            if (withKey) {
+                list += prefix + Schema::key.name;
+            }
+        }
+        std::apply([&list, &prefix](const auto&... columns) {
+            ((list += (list.empty() ? "" : ", "), list += prefix, list += columns.name), ...);
+        }, Schema::columns);
+        return list;
+    }
+
+    // Bind every non-key column in order starting at parameter `first`.
+    // Returns the SQLite result code of the first failing bind, or SQLITE_OK.
+    static int bind(sqlite3_stmt* stmt, const Row& row, int first = 1) {
+        int index = first;
+        int rc = SQLITE_OK;
+        std::apply([&](const auto&... columns) {
+            ((rc = rc == SQLITE_OK ? schema_detail::bindValue(stmt, index++, row.*(columns.member)) : rc), ...);
+        }, Schema::columns);
+        return rc;
+    }
+
+    // Values for updateSql(): all non-key columns followed by the key for the WHERE clause
+    static int bindForUpdate(sqlite3_stmt* stmt, const Row& row) {
+        int rc = bind(stmt, row);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        return schema_detail::bindValue(stmt, static_cast<int>(columnCount) + 1, row.*(Schema::key.member));
+    }
+
+    // Read a row laid out like selectSql(), starting at result column `first`
+    static Row extract(sqlite3_stmt* stmt, int first = 0) {
+        Row row{};
+        int index = first;
+        if constexpr (hasKey) {
+            schema_detail::extractValue(stmt, index++, row.*(Schema::key.member));
+        }
+        std::apply([&](const auto&... columns) {
+            (schema_detail::extractValue(stmt, index++, row.*(columns.member)), ...);
+        }, Schema::columns);
+        return row;
+    }
+
+private:
+    static std::string buildCreate() {
+        std::string sql = std::string("CREATE TABLE IF NOT EXISTS ") + Schema::name + " (";
+        bool first = true;
+        if constexpr (hasKey) {
+            sql += Schema::key.name;
+            sql += " INTEGER PRIMARY KEY AUTOINCREMENT";
+            first = false;
+        }
+        std::apply([&](const auto&... columns) {
+            ((sql += (first ? "" : ", "), first = false, sql += columns.name, sql += " ", sql += columns.definition), ...);
+        }, Schema::columns);
+        if (*Schema::constraints) {
+            sql += ", ";
+            sql += Schema::constraints;
+        }
+        sql += ")";
+        if (*Schema::options) {
+            sql += " ";
+            sql += Schema::options;
+        }
+        sql += ";";
+        return sql;
+    }
+
+    static std::string buildInsert(const char* verb) {
+        std::string sql = std::string(verb) + " INTO " + Schema::name + " (" + columnList(false) + ") VALUES (";
+        for (size_t i = 0; i < columnCount; ++i) {
+            sql += i == 0 ? "?" : ", ?";
+        }
+        sql += ");";
+        return sql;
+    }
+
+    static void appendUpsertColumn(std::string& set, std::string& changed, std::string_view conflictColumn, const char* name) {
+        if (conflictColumn == name) {
+            return;
+        }
+        if (!changed.empty()) {
+            set += ", ";
+            changed += " OR ";
+        }
+        set += std::string(name) + " = excluded." + name;
+        changed += std::string(name) + " IS NOT excluded." + name;
+    }
+
+    static std::string buildUpdate() {
+        std::string sql = std::string("UPDATE ") + Schema::name + " SET ";
+        bool first = true;
+        std::apply([&](const auto&... columns) {
+            ((sql += (first ? "" : ", "), first = false, sql += columns.name, sql += " = ?"), ...);
+        }, Schema::columns);
+        sql += " WHERE ";
+        sql += Schema::key.name;
+        sql += " = ?;";
+        return sql;
+    }
+};
+
+#endif // TABLE_SCHEMA_H
@@ -0,0 +1,32 @@
+#include "TextArena.h"
+#include <cstring>
+
+TextArena::TextArena(size_t blockSize)
+    : blockSize(blockSize), current(0), used(0) {}
+
+std::string_view TextArena::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view("", 0);
+    }
+
+    // Move on to the next block that fits, reusing blocks kept from before clear()
+    while (current < blocks.size() && blocks[current].size - used < text.size()) {
+        ++current;
+        used = 0;
+    }
+    if (current == blocks.size()) {
+        size_t size = text.size() > blockSize ? text.size() : blockSize;
+        blocks.push_back(Block{ std::unique_ptr<char[]>(new char[size]), size });
+        used = 0;
+    }
+
+    char* destination = blocks[current].data.get() + used;
+    std::memcpy(destination, text.data(), text.size());
+    used += text.size();
+    return std::string_view(destination, text.size());
+}
+
+void TextArena::clear() {
+    current = 0;
+    used = 0;
+}
@@ -0,0 +1,30 @@
+#ifndef TEXT_ARENA_H
+#define TEXT_ARENA_H
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Append-only storage for short strings. Text is copied into fixed-size blocks that
+// never move, so returned views stay valid until clear(). clear() keeps the blocks
+// for reuse, so a steady workload stops allocating after warm-up.
+class TextArena {
+public:
+    explicit TextArena(size_t blockSize = 64 * 1024);
+
+    std::string_view store(std::string_view text);
+    void clear();
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    size_t current;     // Block being filled
+    size_t used;        // Bytes used in the current block
+};
+
+#endif // TEXT_ARENA_H
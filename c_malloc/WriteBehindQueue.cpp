@@ -0,0 +1,127 @@
+#include "WriteBehindQueue.h"
+#include <iostream>
+#include <vector>
+
+namespace {
+    bool execute(sqlite3* db, const char* sql) {
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            std::cerr << "Write-behind SQL error: " << errMsg << std::endl;
+            sqlite3_free(errMsg);
+            return false;
+        }
+        return true;
+    }
+}
+
+WriteBehindQueue::WriteBehindQueue()
+    : pool(nullptr), maxDelay(0), maxBatch(1), stopping(false) {}
+
+WriteBehindQueue::~WriteBehindQueue() {
+    stop();
+}
+
+void WriteBehindQueue::start(ConnectionPool& pool, std::chrono::milliseconds maxDelay, size_t maxBatch) {
+    stop();
+    this->pool = &pool;
+    this->maxDelay = maxDelay;
+    this->maxBatch = maxBatch > 0 ? maxBatch : 1;
+    stopping = false;
+    writer = std::thread(&WriteBehindQueue::run, this);
+}
+
+void WriteBehindQueue::stop() {
+    if (!writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+}
+
+bool WriteBehindQueue::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writer.joinable() && !stopping;
+}
+
+std::future<bool> WriteBehindQueue::submit(Operation operation) {
+    PendingWrite pending{ std::move(operation), std::promise<bool>(), std::chrono::steady_clock::now() };
+    std::future<bool> result = pending.done.get_future();
+
+    bool wakeWriter;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping || !writer.joinable()) {
+            pending.done.set_value(false);
+            return result;
+        }
+        queue.push_back(std::move(pending));
+        // The writer sleeps until the first write arrives and again once a batch fills up
+        wakeWriter = queue.size() == 1 || queue.size() >= maxBatch;
+    }
+    if (wakeWriter) {
+        wake.notify_one();
+    }
+    return result;
+}
+
+void WriteBehindQueue::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+
+        // Give later writes until the oldest one's deadline to join its transaction
+        auto deadline = queue.front().queuedAt + maxDelay;
+        wake.wait_until(lock, deadline, [this] { return stopping || queue.size() >= maxBatch; });
+
+        std::deque<PendingWrite> batch;
+        while (!queue.empty() && batch.size() < maxBatch) {
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+
+        lock.unlock();
+        commitBatch(batch);
+        lock.lock();
+    }
+}
+
+void WriteBehindQueue::commitBatch(std::deque<PendingWrite>& batch) {
+    std::vector<bool> results;
+    results.reserve(batch.size());
+
+    bool committed = false;
+    {
+        auto conn = pool->acquireWriter();
+        sqlite3* db = conn.get();
+
+        if (execute(db, "BEGIN TRANSACTION;")) {
+            for (auto& pending : batch) {
+                bool ok = execute(db, "SAVEPOINT queued_write;");
+                if (ok) {
+                    ok = pending.operation();
+                    if (!ok) {
+                        execute(db, "ROLLBACK TO queued_write;");
+                    }
+                    execute(db, "RELEASE queued_write;");
+                }
+                results.push_back(ok);
+            }
+
+            committed = execute(db, "COMMIT;");
+            if (!committed) {
+                execute(db, "ROLLBACK;");
+            }
+        }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].done.set_value(committed && i < results.size() && results[i]);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef WRITE_BEHIND_QUEUE_H
+#define WRITE_BEHIND_QUEUE_H
+
+#include "ConnectionPool.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+// Single background writer that group-commits queued writes.
+// Operations wait until maxDelay has passed since the oldest one was queued or maxBatch
+// of them have piled up, then run back to back inside one transaction on the pool's
+// writer. Each operation gets its own savepoint, so a failing one is rolled back alone.
+// Futures complete after the commit, i.e. once the write is durable.
+class WriteBehindQueue {
+public:
+    // Runs on the writer thread while it holds the writer lease. Operations may use the
+    // pool's re-entrant writer but must not BEGIN/COMMIT transactions themselves.
+    using Operation = std::function<bool()>;
+
+    WriteBehindQueue();
+    ~WriteBehindQueue();
+
+    void start(ConnectionPool& pool, std::chrono::milliseconds maxDelay, size_t maxBatch);
+    // Runs whatever is still queued, then joins the writer thread.
+    void stop();
+    bool isRunning() const;
+
+    std::future<bool> submit(Operation operation);
+
+private:
+    struct PendingWrite {
+        Operation operation;
+        std::promise<bool> done;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    void run();
+    void commitBatch(std::deque<PendingWrite>& batch);
+
+    ConnectionPool* pool;
+    std::chrono::milliseconds maxDelay;
+    size_t maxBatch;
+
+    std::deque<PendingWrite> queue;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread writer;
+};
+
+#endif // WRITE_BEHIND_QUEUE_H
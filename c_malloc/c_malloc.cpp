@@ -5,11 +5,16 @@
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
+#include <chrono>
+#include <vector>
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         std::cerr << "Usage: " << argv[0] << " <mode> [filename.txt]\n";
         std::cerr << "Modes: math / names / db\n";
+        std::cerr << "       db export <table> <output> [csv|binary]\n";
+        std::cerr << "       db stats [slow_ms]\n";
+        std::cerr << "       db import <filename.txt> [natural_key]\n";
         return EXIT_FAILURE;
     }
 
@@ -43,6 +48,96 @@ int main(int argc, char* argv[]) {
             nameManager.readNamesFromFile(filename);
             nameManager.printNames();
         }
+        else if (mode == "db" && argc >= 3 && std::string(argv[2]) == "export") {
+            if (argc < 5) {
+                std::cerr << "Usage: " << argv[0] << " db export <table> <output> [csv|binary]\n";
+                return EXIT_FAILURE;
+            }
+            std::string table = argv[3];
+            std::string output = argv[4];
+            std::string formatName = argc >= 6 ? argv[5] : "csv";
+
+            ExportFormat format;
+            if (formatName == "csv") {
+                format = ExportFormat::Csv;
+            }
+            else if (formatName == "binary") {
+                format = ExportFormat::Binary;
+            }
+            else {
+                std::cerr << "Invalid export format! Use 'csv' or 'binary'.\n";
+                return EXIT_FAILURE;
+            }
+
+            DatabaseManager dbManager("students.db");
+
+            if (!dbManager.openDatabase()) {
+                std::cerr << "Failed to open database.\n";
+                return EXIT_FAILURE;
+            }
+
+            if (!dbManager.exportTable(table, output, format)) {
+                std::cerr << "Failed to export table.\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (mode == "db" && argc >= 3 && std::string(argv[2]) == "stats") {
+            int slowMs = argc >= 4 ? std::stoi(argv[3]) : 100;
+
+            DatabaseManager dbManager("students.db");
+
+            if (!dbManager.openDatabase()) {
+                std::cerr << "Failed to open database.\n";
+                return EXIT_FAILURE;
+            }
+            dbManager.enableQueryStats(std::chrono::milliseconds(slowMs));
+
+            // Run the read paths once over the whole database and report what they cost
+            size_t rows = 0;
+            auto countStudent = [&rows](const StudentRow&) { ++rows; return true; };
+            auto countCourse = [&rows](const CourseRow&) { ++rows; return true; };
+            std::vector<int> courseIds;
+            dbManager.getAllStudents(countStudent);
+            dbManager.getAllCourses([&courseIds](const CourseRow& row) { courseIds.push_back(row.id); return true; });
+
+            PageCursor studentCursor;
+            while (!studentCursor.done && dbManager.getStudentsPage(studentCursor, 1000, countStudent)) {
+            }
+            PageCursor courseCursor;
+            while (!courseCursor.done && dbManager.getCoursesPage(courseCursor, 1000, countCourse)) {
+            }
+            for (int courseId : courseIds) {
+                dbManager.getStudentsInCourse(courseId, [&rows](const EnrolledStudentRow&) { ++rows; return true; });
+            }
+            dbManager.refreshStudentSnapshot();
+
+            dbManager.printQueryStats(std::cout);
+        }
+        else if (mode == "db" && argc >= 3 && std::string(argv[2]) == "import") {
+            if (argc < 4) {
+                std::cerr << "Usage: " << argv[0] << " db import <filename.txt> [natural_key]\n";
+                return EXIT_FAILURE;
+            }
+            std::string filename = argv[3];
+            std::string naturalKey = argc >= 5 ? argv[4] : "phone_number";
+
+            DatabaseManager dbManager("students.db");
+
+            if (!dbManager.openDatabase()) {
+                std::cerr << "Failed to open database.\n";
+                return EXIT_FAILURE;
+            }
+
+            if (!dbManager.createTables()) {
+                std::cerr << "Failed to create tables.\n";
+                return EXIT_FAILURE;
+            }
+
+            if (!dbManager.importStudentsFromTxtFile(filename, naturalKey)) {
+                std::cerr << "Failed to import students from file.\n";
+                return EXIT_FAILURE;
+            }
+        }
         else if (mode == "db") {
             if (argc < 3) {
                 std::cerr << "Filename required for database mode.\n";